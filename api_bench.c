@@ -0,0 +1,214 @@
+/* Load generator for the API path: send_request -> parse -> AdjacencyMatrix.
+ *
+ * Drives the same functions main.c uses against any OpenAI-compatible
+ * endpoint (normally stub_server) from several threads, each with its own
+ * CURL handle, and reports throughput and latency percentiles.
+ *
+ * With -b above 1 the graphs are requested through generateLlmBatch, up to
+ * that many per model call, and the report adds the calls made.
+ *
+ * Usage: api_bench [-u url] [-n requests] [-c concurrency] [-m mode]
+ *                  [-v vertices] [-e edges] [-b batch] [-t max_tokens]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "api_comm.h"
+#include "graph_generator.h"
+#include "graph_matrix.h"
+#include "llm_batch.h"
+
+typedef struct BenchConfig {
+    const char *url;
+    int requests;
+    int concurrency;
+    int mode;
+    int vertices;
+    const char *edges;
+    int batch;            // Graphs per model call, 1 for plain send_request
+    int maxTokens;
+} BenchConfig;
+
+typedef struct BenchState {
+    const BenchConfig *config;
+    char prompt[MAX_INPUT];
+    pthread_mutex_t lock;
+    int next;             // Next request index to hand out
+    double *latencies;    // Seconds per request, indexed by request number
+    int *succeeded;
+    int calls;            // Model calls made, guarded by lock
+} BenchState;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p) {
+    if (count == 0) return 0.0;
+    int idx = (int)(p * (count - 1) + 0.5);
+    return sorted[idx];
+}
+
+static void *bench_worker(void *arg) {
+    BenchState *state = arg;
+    const BenchConfig *config = state->config;
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        fprintf(stderr, "CURL initialization failed\n");
+        return NULL;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, config->url);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+
+    GraphRng rng;
+    graph_rng_seed(&rng, (uint64_t)(uintptr_t)state ^ (uint64_t)time(NULL));
+    while (1) {
+        pthread_mutex_lock(&state->lock);
+        int idx = state->next < config->requests ? state->next : -1;
+        int span = config->requests - state->next < config->batch ? config->requests - state->next : config->batch;
+        if (idx >= 0) state->next += span;
+        pthread_mutex_unlock(&state->lock);
+        if (idx < 0) break;
+
+        double start = now_seconds();
+        int calls = 0;
+        if (span > 1) {
+            AdjacencyMatrix graphs[LLM_BATCH_LIMIT];
+            const char *prompts[LLM_BATCH_LIMIT];
+            for (int i = 0; i < span; i++) prompts[i] = state->prompt;
+            generateLlmBatch(curl, prompts, span, config->mode, config->vertices, config->maxTokens,
+                             &rng, graphs, &calls);
+            double latency = now_seconds() - start;
+            for (int i = 0; i < span; i++) {
+                state->latencies[idx + i] = latency;
+                state->succeeded[idx + i] = graphs[i].matrix != NULL && graphs[i].n == config->vertices;
+                freeAdjacencyMatrix(&graphs[i]);
+            }
+        } else {
+            int ok = 0;
+            char *response = send_request(curl, state->prompt, config->mode);
+            calls++;
+            if (response) {
+                AdjacencyMatrix matrix = config->mode == 0
+                    ? create_matrix_from_extracted(response, config->vertices)
+                    : parseAdjacencyMatrix(response);
+                if (matrix.matrix != NULL) {
+                    ok = matrix.n == config->vertices;
+                    freeAdjacencyMatrix(&matrix);
+                }
+                free(response);
+            }
+            state->latencies[idx] = now_seconds() - start;
+            state->succeeded[idx] = ok;
+        }
+        pthread_mutex_lock(&state->lock);
+        state->calls += calls;
+        pthread_mutex_unlock(&state->lock);
+    }
+
+    curl_easy_cleanup(curl);
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [-u url] [-n requests] [-c concurrency] [-m mode 0|1|2] [-v vertices] [-e edges]\n"
+        "       [-b batch] [-t max_tokens]\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config = {API_URL, 200, 4, 2, 8, "", 1, LLM_BATCH_MAX_TOKENS};
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-u") == 0) config.url = argv[++i];
+        else if (strcmp(argv[i], "-n") == 0) config.requests = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0) config.concurrency = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-m") == 0) config.mode = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0) config.vertices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-e") == 0) config.edges = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0) config.batch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0) config.maxTokens = atoi(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.requests <= 0 || config.concurrency <= 0 || config.vertices <= 0 ||
+        config.mode < 0 || config.mode > 2 || config.batch <= 0 || config.batch > LLM_BATCH_LIMIT ||
+        config.maxTokens <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    BenchState state;
+    state.config = &config;
+    state.next = 0;
+    state.calls = 0;
+    // Same prompt shapes main.c builds for each mode
+    if (config.mode == 2) {
+        snprintf(state.prompt, sizeof(state.prompt), "%d", config.vertices);
+    } else {
+        snprintf(state.prompt, sizeof(state.prompt), "%d %s", config.vertices, config.edges);
+    }
+    state.latencies = calloc(config.requests, sizeof(double));
+    state.succeeded = calloc(config.requests, sizeof(int));
+    pthread_t *threads = malloc(config.concurrency * sizeof(pthread_t));
+    if (!state.latencies || !state.succeeded || !threads) {
+        fprintf(stderr, "Memory allocation error\n");
+        free(state.latencies);
+        free(state.succeeded);
+        free(threads);
+        return 1;
+    }
+    pthread_mutex_init(&state.lock, NULL);
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    double start = now_seconds();
+    int started = 0;
+    for (; started < config.concurrency; started++) {
+        if (pthread_create(&threads[started], NULL, bench_worker, &state) != 0) {
+            fprintf(stderr, "Error creating worker thread\n");
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double wall = now_seconds() - start;
+
+    int ok = 0;
+    for (int i = 0; i < config.requests; i++) ok += state.succeeded[i];
+    qsort(state.latencies, config.requests, sizeof(double), compare_doubles);
+
+    printf("url:          %s\n", config.url);
+    printf("mode:         %d, vertices: %d, concurrency: %d\n", config.mode, config.vertices, started);
+    printf("requests:     %d (ok %d, failed %d)\n", config.requests, ok, config.requests - ok);
+    printf("wall time:    %.3f s\n", wall);
+    printf("throughput:   %.1f req/s, %.1f graphs/s\n", config.requests / wall, ok / wall);
+    printf("model calls:  %d, %.2f graphs per call\n", state.calls, state.calls > 0 ? (double)ok / state.calls : 0.0);
+    printf("latency p50:  %.3f ms\n", percentile(state.latencies, config.requests, 0.50) * 1000.0);
+    printf("latency p99:  %.3f ms\n", percentile(state.latencies, config.requests, 0.99) * 1000.0);
+    printf("latency max:  %.3f ms\n", state.latencies[config.requests - 1] * 1000.0);
+
+    curl_global_cleanup();
+    pthread_mutex_destroy(&state.lock);
+    free(threads);
+    free(state.latencies);
+    free(state.succeeded);
+    return ok == config.requests ? 0 : 2;
+}
@@ -1,4 +1,5 @@
 #include "api_comm.h"
+#include "stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +14,7 @@ size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userdata) {
     }
 
     mem->response = tmp;
+    STATS_ALLOC(total_size + 1);
     memcpy(&(mem->response[mem->size]), ptr, total_size);
     mem->size += total_size;
     mem->response[mem->size] = '\0';
@@ -20,60 +22,58 @@ size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userdata) {
     return total_size;
 }
 
-char *send_request(CURL *curl, const char *user_prompt, int mode) {
+// System prompts of the request modes, indexed by mode
+static const char *const systemPrompts[] = {
+    // 0: extract only, F where not specified; the F cells are filled locally afterwards
+    "You are a smart AI created ONLY to extract data about an Adjacency Matrix from the user's input, as follows: "
+    "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
+    "-`n` is the number of vertices (rows/columns), extracted from the input."
+    "-`aij` is `1` if a directed edge from vertex `i` to vertex `j` is explicitly specified, `0` if explicitly no edge, or `F` if not specified. "
+    "- Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix. "
+    "- If the input mentions 'random' or doesn't specify connections, use `F` for those positions; do NOT generate random values yourself. "
+    "- The graph is directed: `aij = 1` does NOT imply `aji = 1`"
+    "- Example: Input '3 A->B, B->C' -> `Vertices=3>>>F1F|FF1|FFF`"
+    "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on",
+    // 1: zeros for every connection the user does not specify
+    "You are an AI designed exclusively to generate directed graphs based on user input. "
+    "Your only task is to create and return an adjacency matrix and its row number in this exact format: "
+    "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
+    "-`n` is the number of vertices"
+    "-'a34' connection from C to D"
+    "-`aij` is 1 if there is a directed edge from vertex `i` to `j`, `0` otherwise."
+    "-Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix."
+    "-IMPORTANT:Every connection which is not specified by the user's message must be set to 0, unless user explicitly asks to randomly generate them"
+    "If the connection's not possible e.g 3 vertices and connection F->G return a matrix full of 'X'"
+    "-The graph is directed: `aij = 1` does NOT imply `aji = 1`"
+    "-Example of output from input 3 A->B, B->C:`Vertices=3>>>010|001|000` means a 3-vertex directed graph with edges A->B, B->C."
+    "And the same from input: 'Graph with 3 vertices A->B', because you have to put zeros on every connection that the user does not specify"
+    "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on.",
+    // 2: totally random
+    "You are an AI designed exclusively to generate directed graphs based on user input. "
+    "Your only task is to create and return an adjacency matrix and its row number in this exact format: "
+    "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
+    "- `n` is the number of vertices (rows/columns)."
+    "- `aij` is 1 if there is a directed edge from vertex `i` to vertex `j`, otherwise 0."
+    "- The graph is directed: `aij = 1` does NOT imply `aji = 1`."
+    "- The values in the adjacency matrix must be randomly generated (0 or 1) for each vertex connection."
+    "- Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix."
+    "- Example of output: `Vertices=3>>>010|001|000` represents a 3-vertex directed graph with edges 1->2 and 2->3."
+    "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on"
+};
+
+// Appended to the system prompt when several requests share one completion
+static const char batchInstructions[] =
+    " The user message holds several numbered requests, one per line as `k) request`. "
+    "Answer every request separately and in order, in the format above prefixed with its number as `k)`, "
+    "and separate the answers with `" LLM_BATCH_SEPARATOR "`. "
+    "Example of output for two requests: `1)Vertices=2>>>01|00" LLM_BATCH_SEPARATOR "2)Vertices=2>>>00|10`";
+
+// Posts json_data to the URL already set on curl and returns the raw response
+static char *post_request(CURL *curl, const char *json_data) {
     struct Memory chunk = {NULL, 0};
     struct curl_slist *headers = NULL;
-    char json_data[MAX_INPUT + 2048];
-    if (mode == 1) {    //Specified only if not explicitly said
-        snprintf(json_data, sizeof(json_data),
-            "{\"model\": \"%s\", \"messages\": ["
-            "{\"role\": \"system\", \"content\": \"You are an AI designed exclusively to generate directed graphs based on user input. "
-            "Your only task is to create and return an adjacency matrix and its row number in this exact format: "
-            "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
-            "-`n` is the number of vertices"
-            "-'a34' connection from C to D"
-            "-`aij` is 1 if there is a directed edge from vertex `i` to `j`, `0` otherwise."
-            "-Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix."
-            "-IMPORTANT:Every connection which is not specified by the user's message must be set to 0, unless user explicitly asks to randomly generate them"
-            "If the connection's not possible e.g 3 vertices and connection F->G return a matrix full of 'X'"
-            "-The graph is directed: `aij = 1` does NOT imply `aji = 1`"
-            "-Example of output from input 3 A->B, B->C:`Vertices=3>>>010|001|000` means a 3-vertex directed graph with edges A->B, B->C."
-            "And the same from input: 'Graph with 3 vertices A->B', because you have to put zeros on every connection that the user does not specify"
-            "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on.\"}, "
-            "{\"role\": \"user\", \"content\": \"%s\"}], \"max_tokens\": 300}",
-            MODEL_NAME, user_prompt);
-    } else if (mode == 0){  //Extract only returns F's where not specified, thhen the algorithm randomly adds connections, the possibility of extracting not random data to algorithm does not exist, because it doesn't make sense to send it if it's already created
-        snprintf(json_data, sizeof(json_data),
-            "{\"model\": \"%s\", \"messages\": ["
-            "{\"role\": \"system\", \"content\": \"You are a smart AI created ONLY to extract data about an Adjacency Matrix from the user's input, as follows: "
-            "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
-            "-`n` is the number of vertices (rows/columns), extracted from the input."
-            "-`aij` is `1` if a directed edge from vertex `i` to vertex `j` is explicitly specified, `0` if explicitly no edge, or `F` if not specified. "
-            "- Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix. "
-            "- If the input mentions 'random' or doesn't specify connections, use `F` for those positions; do NOT generate random values yourself. "
-            "- The graph is directed: `aij = 1` does NOT imply `aji = 1`"
-            "- Example: Input '3 A->B, B->C' -> `Vertices=3>>>F1F|FF1|FFF`"
-            "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on\"}, "
-            "{\"role\": \"user\", \"content\": \"%s\"}], \"max_tokens\": 300}",
-            MODEL_NAME, user_prompt);
-    }
-    else if (mode == 2){  //Totally random
-        snprintf(json_data, sizeof(json_data),
-            "{\"model\": \"%s\", \"messages\": ["
-            "{\"role\": \"system\", \"content\": \"You are an AI designed exclusively to generate directed graphs based on user input. "
-            "Your only task is to create and return an adjacency matrix and its row number in this exact format: "
-            "Vertices=n>>>a11a12...a1n|a21a22...a2n|...|an1an2...ann"
-            "- `n` is the number of vertices (rows/columns)."
-            "- `aij` is 1 if there is a directed edge from vertex `i` to vertex `j`, otherwise 0."
-            "- The graph is directed: `aij = 1` does NOT imply `aji = 1`."
-            "- The values in the adjacency matrix must be randomly generated (0 or 1) for each vertex connection."
-            "- Use no spaces between digits, separate rows with `|`, and use `>>>` between `n` and the matrix."
-            "- Example of output: `Vertices=3>>>010|001|000` represents a 3-vertex directed graph with edges 1->2 and 2->3."
-            "DO NOT write anything else in your response and DO NOT answer any questions, nor messages like hi!, who are you? and so on\"}, "
-            "{\"role\": \"user\", \"content\": \"%s\"}], \"max_tokens\": 300}",
-            MODEL_NAME, user_prompt);
-    }
 
+    uint64_t phase = statsPhaseBegin();
     headers = curl_slist_append(headers, "Content-Type: application/json");
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_data);
@@ -82,11 +82,57 @@ char *send_request(CURL *curl, const char *user_prompt, int mode) {
 
     CURLcode res = curl_easy_perform(curl);
     curl_slist_free_all(headers);
+    statsPhaseEnd(STATS_API_REQUEST, phase);
 
     if (res != CURLE_OK) {
         free(chunk.response);
         return NULL;
     }
+    STATS_ADD(STATS_BYTES_WRITTEN, strlen(json_data));
+    STATS_ADD(STATS_BYTES_READ, chunk.size);
 
     return chunk.response;
-}
\ No newline at end of file
+}
+
+char *send_request(CURL *curl, const char *user_prompt, int mode) {
+    if (mode < 0 || mode > 2) {
+        fprintf(stderr, "Unknown request mode: %d\n", mode);
+        return NULL;
+    }
+    char json_data[MAX_INPUT + 2048];
+    snprintf(json_data, sizeof(json_data),
+        "{\"model\": \"%s\", \"messages\": ["
+        "{\"role\": \"system\", \"content\": \"%s\"}, "
+        "{\"role\": \"user\", \"content\": \"%s\"}], \"max_tokens\": 300}",
+        MODEL_NAME, systemPrompts[mode], user_prompt);
+    return post_request(curl, json_data);
+}
+
+char *send_batch_request(CURL *curl, const char *const *user_prompts, int count, int mode, int max_tokens) {
+    if (mode < 0 || mode > 2) {
+        fprintf(stderr, "Unknown request mode: %d\n", mode);
+        return NULL;
+    }
+    size_t size = strlen(systemPrompts[mode]) + sizeof(batchInstructions) + 256;
+    for (int i = 0; i < count; i++) {
+        size += strlen(user_prompts[i]) + 16;
+    }
+    char *json_data = malloc(size);
+    if (!json_data) {
+        fprintf(stderr, "Memory allocation error for batch request\n");
+        return NULL;
+    }
+    int length = snprintf(json_data, size,
+        "{\"model\": \"%s\", \"messages\": ["
+        "{\"role\": \"system\", \"content\": \"%s%s\"}, "
+        "{\"role\": \"user\", \"content\": \"",
+        MODEL_NAME, systemPrompts[mode], batchInstructions);
+    for (int i = 0; i < count; i++) {
+        length += snprintf(json_data + length, size - length, "%s%d) %s", i > 0 ? "\\n" : "", i + 1, user_prompts[i]);
+    }
+    snprintf(json_data + length, size - length, "\"}], \"max_tokens\": %d}", max_tokens);
+
+    char *response = post_request(curl, json_data);
+    free(json_data);
+    return response;
+}
@@ -6,6 +6,7 @@
 #define API_URL "http://127.0.0.1:1234/v1/chat/completions"
 #define MODEL_NAME "qwen2.5-7b-instruct-1m"
 #define MAX_INPUT 512
+#define LLM_BATCH_SEPARATOR "###"  // Between the answers of a batched request
 
 struct Memory {
     char *response;
@@ -13,5 +14,9 @@ struct Memory {
 };
 
 char *send_request(CURL *curl, const char *user_prompt, int mode);
+/* One completion for `count` prompts of the same mode: the user message
+   numbers them "1) ...", "2) ..." and the model answers each as
+   "k)Vertices=..." separated by LLM_BATCH_SEPARATOR. */
+char *send_batch_request(CURL *curl, const char *const *user_prompts, int count, int mode, int max_tokens);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,788 @@
+#include "batch_jobs.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "api_comm.h"
+#include "csrrg.h"
+#include "edge_list.h"
+#include "graph_generator.h"
+#include "graph_matrix.h"
+#include "llm_batch.h"
+#include "utils.h"
+
+#define BATCH_OUT_BUFFER (1 << 20)  // Per-worker stdio buffer reused for every output file
+#define BATCH_MAX_LINE 65536
+#define BATCH_DEFAULT_THREADS 4
+#define BATCH_DEFAULT_PARSERS 4
+#define BATCH_MAX_DENSE 16384             // Largest edge list graph written as a dense matrix
+#define BATCH_ARENA_SIZE (1 << 20)        // Initial per-worker matrix arena, grows on demand
+#define BATCH_ARENA_LIMIT (64 << 20)      // Largest arena; bigger matrices come from the heap
+
+/* One unit of work: repetition `rep` of job `job`. */
+typedef struct BatchTask {
+    int job;
+    int rep;
+} BatchTask;
+
+typedef struct BatchShared {
+    const GenerationJob *jobs;
+    BatchTask *tasks;
+    int taskCount;
+    int next;
+    uint64_t baseSeed;          // Used for jobs without an explicit seed
+    const char *apiUrl;
+    pthread_mutex_t lock;       // Guards next
+    pthread_mutex_t stdoutLock; // Keeps graphs written to "-" from interleaving
+    FingerprintSet seen;        // Fingerprints of the graphs written by dedup jobs
+    int *spans;                 // Per job: repetitions a worker takes at once, above 1 for batched LLM jobs
+} BatchShared;
+
+/* State a worker keeps across all the jobs it runs. */
+typedef struct BatchWorker {
+    BatchShared *shared;
+    GraphRng rng;
+    CURL *curl;                 // Created on the first LLM job, then reused
+    char *outBuffer;
+    MatrixArena arena;          // Backs every matrix the worker builds, reset per task
+    int produced;
+    int failed;
+    int duplicates;
+    int requests;               // Model calls made
+    int llmGraphs;              // Graphs obtained from those calls
+} BatchWorker;
+
+static const struct {
+    const char *name;
+    GenerationType type;
+} generationTypes[] = {
+    {"random", GEN_RANDOM},
+    {"user", GEN_USER},
+    {"llm-random", GEN_LLM_RANDOM},
+    {"llm-user", GEN_LLM_USER},
+    {"llm-chat", GEN_LLM_CHAT},
+    {"llm-extract", GEN_LLM_EXTRACT},
+    {"edgelist", GEN_EDGE_LIST},
+};
+
+static const struct {
+    const char *name;
+    OutputFormat format;
+} outputFormats[] = {
+    {"matrix", OUTPUT_MATRIX},
+    {"dense", OUTPUT_DENSE},
+    {"csrrg", OUTPUT_CSRRG},
+    {"edges", OUTPUT_EDGES},
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Only a single "%d" may appear in an output path template
+static int valid_output_template(const char *path) {
+    int placeholders = 0;
+    for (const char *p = strchr(path, '%'); p; p = strchr(p + 2, '%')) {
+        if (p[1] != 'd') return 0;
+        placeholders++;
+    }
+    return placeholders <= 1;
+}
+
+static int set_job_field(GenerationJob *job, const char *key, const char *value) {
+    if (strcmp(key, "type") == 0) {
+        for (size_t i = 0; i < sizeof(generationTypes) / sizeof(generationTypes[0]); i++) {
+            if (strcasecmp(value, generationTypes[i].name) == 0) {
+                job->type = generationTypes[i].type;
+                return 0;
+            }
+        }
+        fprintf(stderr, "Unknown generation type: %s\n", value);
+        return -1;
+    } else if (strcmp(key, "format") == 0) {
+        for (size_t i = 0; i < sizeof(outputFormats) / sizeof(outputFormats[0]); i++) {
+            if (strcasecmp(value, outputFormats[i].name) == 0) {
+                job->format = outputFormats[i].format;
+                return 0;
+            }
+        }
+        fprintf(stderr, "Unknown output format: %s\n", value);
+        return -1;
+    } else if (strcmp(key, "n") == 0) {
+        job->n = parseVertexCount(value);
+        return job->n < 0 ? -1 : 0;
+    } else if (strcmp(key, "density") == 0) {
+        job->density = atof(value);
+        return 0;
+    } else if (strcmp(key, "seed") == 0) {
+        job->seed = strtoull(value, NULL, 10);
+        job->hasSeed = 1;
+        return 0;
+    } else if (strcmp(key, "count") == 0) {
+        job->count = atoi(value);
+        return 0;
+    } else if (strcmp(key, "parsers") == 0) {
+        job->parsers = atoi(value);
+        return 0;
+    } else if (strcmp(key, "batch") == 0) {
+        job->batch = strcasecmp(value, "auto") == 0 ? LLM_BATCH_LIMIT : atoi(value);
+        return 0;
+    } else if (strcmp(key, "max_tokens") == 0) {
+        job->maxTokens = atoi(value);
+        return 0;
+    } else if (strcmp(key, "dedup") == 0) {
+        if (strcasecmp(value, "exact") == 0) {
+            job->dedup = FINGERPRINT_EXACT;
+        } else if (strcasecmp(value, "iso") == 0) {
+            job->dedup = FINGERPRINT_ISO;
+        } else if (strcasecmp(value, "none") == 0) {
+            job->dedup = FINGERPRINT_NONE;
+        } else {
+            fprintf(stderr, "Unknown dedup mode (expected none, exact or iso): %s\n", value);
+            return -1;
+        }
+        return 0;
+    } else if (strcmp(key, "labels") == 0) {
+        if (strcasecmp(value, "numeric") == 0) {
+            job->labelFlags = EDGE_LIST_NUMERIC;
+        } else if (strcasecmp(value, "string") == 0) {
+            job->labelFlags = 0;
+        } else {
+            fprintf(stderr, "Unknown label kind (expected numeric or string): %s\n", value);
+            return -1;
+        }
+        return 0;
+    }
+
+    char **target = NULL;
+    if (strcmp(key, "edges") == 0) target = &job->edges;
+    else if (strcmp(key, "prompt") == 0) target = &job->prompt;
+    else if (strcmp(key, "out") == 0) target = &job->output;
+    else if (strcmp(key, "in") == 0) target = &job->input;
+    if (!target) {
+        fprintf(stderr, "Unknown job key: %s\n", key);
+        return -1;
+    }
+    free(*target);
+    *target = strdup(value);
+    if (!*target) {
+        fprintf(stderr, "Memory allocation error for job field %s\n", key);
+        return -1;
+    }
+    return 0;
+}
+
+/* Parses a job description made of whitespace-separated key=value pairs,
+   e.g. type=user n=5 edges="A->B, B->C" out=g%d.csrrg format=csrrg count=10
+   Values containing spaces are written in double quotes. */
+int parseGenerationJob(const char *spec, GenerationJob *job) {
+    memset(job, 0, sizeof(*job));
+    job->type = GEN_RANDOM;
+    job->density = 0.5;
+    job->count = 1;
+    job->format = OUTPUT_MATRIX;
+    job->parsers = BATCH_DEFAULT_PARSERS;
+    job->batch = 1;
+    job->maxTokens = LLM_BATCH_MAX_TOKENS;
+
+    char key[32];
+    char *value = malloc(strlen(spec) + 1);
+    if (!value) {
+        fprintf(stderr, "Memory allocation error for job value\n");
+        return -1;
+    }
+    const char *p = spec;
+    while (*p) {
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0') break;
+
+        size_t keyLen = 0;
+        while (*p && *p != '=' && !isspace((unsigned char)*p)) {
+            if (keyLen < sizeof(key) - 1) key[keyLen++] = *p;
+            p++;
+        }
+        key[keyLen] = '\0';
+        if (*p != '=') {
+            fprintf(stderr, "Invalid job field (expected key=value): %s\n", key);
+            goto fail;
+        }
+        p++;
+
+        size_t valueLen = 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') value[valueLen++] = *p++;
+            if (*p != '"') {
+                fprintf(stderr, "Unterminated quoted value for %s\n", key);
+                goto fail;
+            }
+            p++;
+        } else {
+            while (*p && !isspace((unsigned char)*p)) value[valueLen++] = *p++;
+        }
+        value[valueLen] = '\0';
+        if (set_job_field(job, key, value) != 0) goto fail;
+    }
+    free(value);
+
+    if (!job->output) {
+        job->output = strdup("-");
+        if (!job->output) {
+            fprintf(stderr, "Memory allocation error for job output\n");
+            freeGenerationJob(job);
+            return -1;
+        }
+    }
+    if ((job->type == GEN_LLM_CHAT || job->type == GEN_LLM_EXTRACT) && !job->prompt) {
+        fprintf(stderr, "Job type requires prompt=\"...\"\n");
+    } else if (job->type == GEN_EDGE_LIST && !job->input) {
+        fprintf(stderr, "Job type requires in=path\n");
+    } else if (job->type != GEN_LLM_CHAT && job->type != GEN_LLM_EXTRACT &&
+               job->type != GEN_EDGE_LIST && job->n <= 0) {
+        fprintf(stderr, "Job type requires n > 0\n");
+    } else if (job->parsers <= 0) {
+        fprintf(stderr, "Parser count must be positive\n");
+    } else if (job->batch <= 0 || job->batch > LLM_BATCH_LIMIT) {
+        fprintf(stderr, "Batch size must be between 1 and %d (or auto)\n", LLM_BATCH_LIMIT);
+    } else if (job->maxTokens <= 0) {
+        fprintf(stderr, "max_tokens must be positive\n");
+    } else if (job->density < 0.0 || job->density > 1.0) {
+        fprintf(stderr, "Density must be between 0 and 1\n");
+    } else if (job->count <= 0) {
+        fprintf(stderr, "Count must be positive\n");
+    } else if (!valid_output_template(job->output)) {
+        fprintf(stderr, "Output path may contain only a single %%d: %s\n", job->output);
+    } else if (job->count > 1 && strcmp(job->output, "-") != 0 && !strstr(job->output, "%d")) {
+        fprintf(stderr, "Output path needs %%d when count > 1: %s\n", job->output);
+    } else {
+        return 0;
+    }
+    freeGenerationJob(job);
+    return -1;
+
+fail:
+    free(value);
+    freeGenerationJob(job);
+    return -1;
+}
+
+/* Reads one job per line; blank lines and lines starting with '#' are skipped. */
+int loadGenerationJobs(const char *fileName, GenerationJob **jobs, int *count) {
+    FILE *f = strcmp(fileName, "-") == 0 ? stdin : fopen(fileName, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening job file %s\n", fileName);
+        return -4;
+    }
+    char *line = malloc(BATCH_MAX_LINE);
+    if (!line) {
+        fprintf(stderr, "Memory allocation error for job line\n");
+        if (f != stdin) fclose(f);
+        return -2;
+    }
+
+    int status = 0;
+    int lineNo = 0;
+    while (fgets(line, BATCH_MAX_LINE, f)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = 0;
+        const char *start = line;
+        while (isspace((unsigned char)*start)) start++;
+        if (*start == '\0' || *start == '#') continue;
+
+        GenerationJob *temp = realloc(*jobs, (*count + 1) * sizeof(GenerationJob));
+        if (!temp) {
+            fprintf(stderr, "Memory allocation error during jobs realloc\n");
+            status = -5;
+            break;
+        }
+        *jobs = temp;
+        if (parseGenerationJob(start, &(*jobs)[*count]) != 0) {
+            fprintf(stderr, "Invalid job on line %d of %s\n", lineNo, fileName);
+            status = -1;
+            break;
+        }
+        (*count)++;
+    }
+
+    free(line);
+    if (f != stdin) fclose(f);
+    return status;
+}
+
+void freeGenerationJob(GenerationJob *job) {
+    free(job->edges);
+    free(job->prompt);
+    free(job->output);
+    free(job->input);
+    job->edges = job->prompt = job->output = job->input = NULL;
+}
+
+static void write_graph(FILE *file, const AdjacencyMatrix *matrix, OutputFormat format) {
+    switch (format) {
+        case OUTPUT_MATRIX:
+            printAdjacencyMatrixRowsToFile(file, matrix);
+            break;
+        case OUTPUT_DENSE:
+            printAdjacencyMatrixToFile(file, matrix, matrix->n);
+            printConnectionsToFile(file, matrix);
+            break;
+        case OUTPUT_CSRRG:
+            writeCsrrgFile(file, matrix);
+            break;
+        case OUTPUT_EDGES:
+            printConnectionsToFile(file, matrix);
+            break;
+    }
+}
+
+static int write_sparse_graph(FILE *file, const SparseGraph *graph, const LabelInterner *labels,
+                              OutputFormat format) {
+    if (format == OUTPUT_CSRRG) {
+        return writeSparseCsrrgFile(file, graph);
+    } else if (format == OUTPUT_EDGES) {
+        if (!labels) {
+            printSparseConnectionsToFile(file, graph);
+            return 0;
+        }
+        for (int i = 0; i < graph->n; i++) {
+            for (int k = graph->rowPtr[i]; k < graph->rowPtr[i + 1]; k++) {
+                fprintf(file, "%s - %s\n", labelName(labels, i), labelName(labels, graph->colIdx[k]));
+            }
+        }
+        return 0;
+    }
+
+    if (graph->n > BATCH_MAX_DENSE) {
+        fprintf(stderr, "Graph with %d vertices is too large for a dense format, use csrrg or edges\n", graph->n);
+        return -1;
+    }
+    AdjacencyMatrix matrix = sparseGraphToMatrix(graph);
+    if (matrix.matrix == NULL) return -2;
+    write_graph(file, &matrix, format);
+    freeAdjacencyMatrix(&matrix);
+    return 0;
+}
+
+static int ensure_curl(BatchWorker *worker) {
+    if (worker->curl) return 0;
+    worker->curl = curl_easy_init();
+    if (!worker->curl) {
+        fprintf(stderr, "CURL initialization failed\n");
+        return -1;
+    }
+    curl_easy_setopt(worker->curl, CURLOPT_URL, worker->shared->apiUrl);
+    curl_easy_setopt(worker->curl, CURLOPT_POST, 1L);
+    return 0;
+}
+
+/* Prompt and request mode of an LLM job; *n is the vertex count when the
+   job gives one (always for extract jobs), 0 otherwise. */
+static int build_llm_prompt(const GenerationJob *job, char *prompt, int *mode, int *n) {
+    *mode = 1;
+    *n = job->n;
+    if (job->type == GEN_LLM_RANDOM) {
+        snprintf(prompt, MAX_INPUT, "%d", job->n);
+        *mode = 2;
+    } else if (job->type == GEN_LLM_USER) {
+        snprintf(prompt, MAX_INPUT, "%d %s", job->n, job->edges ? job->edges : "");
+    } else {
+        snprintf(prompt, MAX_INPUT, "%s", job->prompt);
+        if (job->type == GEN_LLM_EXTRACT) {
+            *mode = 0;
+            if (*n <= 0) *n = parseVertexCount(prompt);
+            if (*n <= 0) {
+                fprintf(stderr, "Could not determine number of vertices\n");
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static AdjacencyMatrix generate_for_job(BatchWorker *worker, const GenerationJob *job) {
+    AdjacencyMatrix matrix = {NULL, 0, 0};
+    if (job->type == GEN_RANDOM) {
+        return generate_random_graph_r(job->n, job->density, &worker->rng);
+    } else if (job->type == GEN_USER) {
+        return generate_user_defined_graph(job->n, job->edges ? job->edges : "");
+    }
+
+    char prompt[MAX_INPUT];
+    int mode, n;
+    if (ensure_curl(worker) != 0 || build_llm_prompt(job, prompt, &mode, &n) != 0) return matrix;
+
+    char *response = send_request(worker->curl, prompt, mode);
+    worker->requests++;
+    if (!response) {
+        fprintf(stderr, "API communication error\n");
+        return matrix;
+    }
+    matrix = mode == 0 ? create_matrix_from_extracted_r(response, n, &worker->rng)
+                       : parseAdjacencyMatrix(response);
+    free(response);
+    worker->llmGraphs += matrix.matrix != NULL;
+    return matrix;
+}
+
+/* Opens the job's output (stdout under its lock, or a file using the
+   worker's buffer) and writes whichever of matrix/graph is given. */
+static int write_output(BatchWorker *worker, const GenerationJob *job, int rep,
+                        const AdjacencyMatrix *matrix, const SparseGraph *graph,
+                        const LabelInterner *labels) {
+    int status = 0;
+    if (strcmp(job->output, "-") == 0) {
+        pthread_mutex_lock(&worker->shared->stdoutLock);
+        if (matrix) {
+            write_graph(stdout, matrix, job->format);
+        } else {
+            status = write_sparse_graph(stdout, graph, labels, job->format);
+        }
+        fflush(stdout);
+        pthread_mutex_unlock(&worker->shared->stdoutLock);
+        return status;
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), job->output, rep);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error opening output file %s\n", path);
+        return -3;
+    }
+    setvbuf(file, worker->outBuffer, _IOFBF, BATCH_OUT_BUFFER);
+    if (matrix) {
+        write_graph(file, matrix, job->format);
+    } else {
+        status = write_sparse_graph(file, graph, labels, job->format);
+    }
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Error writing output file %s\n", path);
+        status = -3;
+    }
+    return status;
+}
+
+static int run_edge_list_task(BatchWorker *worker, const GenerationJob *job, int rep) {
+    LabelInterner labels;
+    int numeric = job->labelFlags & EDGE_LIST_NUMERIC;
+    if (!numeric && initLabelInterner(&labels) != 0) return -2;
+
+    SparseGraph graph;
+    int status = readEdgeListFile(job->input, job->labelFlags, job->parsers, &graph, numeric ? NULL : &labels);
+    if (status == 0) {
+        uint64_t hash;
+        if (job->dedup != FINGERPRINT_NONE && sparseGraphFingerprint(&graph, job->dedup, &hash) == 0 &&
+            fingerprintSetInsert(&worker->shared->seen, hash) == 0) {
+            status = 1;
+        } else {
+            status = write_output(worker, job, rep, NULL, &graph, numeric ? NULL : &labels);
+        }
+        freeSparseGraph(&graph);
+    }
+    if (!numeric) freeLabelInterner(&labels);
+    return status;
+}
+
+static uint64_t task_seed(const BatchWorker *worker, const BatchTask *task, int taskIndex) {
+    const GenerationJob *job = &worker->shared->jobs[task->job];
+    return job->hasSeed ? job->seed + task->rep : worker->shared->baseSeed + taskIndex;
+}
+
+// Drops the matrix if it is a duplicate, writes it otherwise; frees it either way
+static int finish_task(BatchWorker *worker, const GenerationJob *job, int rep, AdjacencyMatrix *matrix) {
+    uint64_t hash;
+    if (job->dedup != FINGERPRINT_NONE && graphFingerprint(matrix, job->dedup, &hash) == 0 &&
+        fingerprintSetInsert(&worker->shared->seen, hash) == 0) {
+        freeAdjacencyMatrix(matrix);
+        return 1;  // Duplicate of a graph already written
+    }
+    int status = write_output(worker, job, rep, matrix, NULL, NULL);
+    freeAdjacencyMatrix(matrix);
+    return status;
+}
+
+static int run_task(BatchWorker *worker, const BatchTask *task, int taskIndex) {
+    const GenerationJob *job = &worker->shared->jobs[task->job];
+    if (job->type == GEN_EDGE_LIST) {
+        return run_edge_list_task(worker, job, task->rep);
+    }
+
+    graph_rng_seed(&worker->rng, task_seed(worker, task, taskIndex));
+
+    AdjacencyMatrix matrix = generate_for_job(worker, job);
+    if (matrix.matrix == NULL) {
+        fprintf(stderr, "Failed to create graph for job %d (repetition %d)\n", task->job + 1, task->rep);
+        return -1;
+    }
+    return finish_task(worker, job, task->rep, &matrix);
+}
+
+/* Repetitions first .. first + span - 1 of one LLM job, packed into one
+   request by generateLlmBatch. Stores each repetition's run_task status. */
+static void run_llm_batch(BatchWorker *worker, int first, int span, int *statuses) {
+    const BatchTask *tasks = worker->shared->tasks + first;
+    const GenerationJob *job = &worker->shared->jobs[tasks[0].job];
+    AdjacencyMatrix graphs[LLM_BATCH_LIMIT];
+    const char *prompts[LLM_BATCH_LIMIT];
+    char prompt[MAX_INPUT];
+    int mode, n;
+
+    memset(graphs, 0, sizeof(graphs));
+    if (ensure_curl(worker) == 0 && build_llm_prompt(job, prompt, &mode, &n) == 0) {
+        for (int i = 0; i < span; i++) prompts[i] = prompt;
+        graph_rng_seed(&worker->rng, task_seed(worker, &tasks[0], first));
+        worker->llmGraphs += generateLlmBatch(worker->curl, prompts, span, mode, n, job->maxTokens,
+                                              &worker->rng, graphs, &worker->requests);
+    }
+    for (int i = 0; i < span; i++) {
+        if (graphs[i].matrix == NULL) {
+            fprintf(stderr, "Failed to create graph for job %d (repetition %d)\n", tasks[i].job + 1, tasks[i].rep);
+            statuses[i] = -1;
+        } else {
+            statuses[i] = finish_task(worker, job, tasks[i].rep, &graphs[i]);
+        }
+    }
+}
+
+static void *batch_worker(void *arg) {
+    BatchWorker *worker = arg;
+    BatchShared *shared = worker->shared;
+    int hasArena = initMatrixArena(&worker->arena, BATCH_ARENA_SIZE, BATCH_ARENA_LIMIT) == 0;
+    if (hasArena) useMatrixArena(&worker->arena);
+    while (1) {
+        // Repetitions of a batched job are taken together, up to its span
+        pthread_mutex_lock(&shared->lock);
+        int idx = shared->next < shared->taskCount ? shared->next : -1;
+        int span = 0;
+        if (idx >= 0) {
+            int job = shared->tasks[idx].job;
+            while (span < shared->spans[job] && shared->next < shared->taskCount &&
+                   shared->tasks[shared->next].job == job) {
+                shared->next++;
+                span++;
+            }
+        }
+        pthread_mutex_unlock(&shared->lock);
+        if (idx < 0) break;
+
+        int statuses[LLM_BATCH_LIMIT];
+        if (span > 1) {
+            run_llm_batch(worker, idx, span, statuses);
+        } else {
+            statuses[0] = run_task(worker, &shared->tasks[idx], idx);
+        }
+        for (int i = 0; i < span; i++) {
+            if (statuses[i] == 0) {
+                worker->produced++;
+            } else if (statuses[i] == 1) {
+                worker->duplicates++;
+            } else {
+                worker->failed++;
+            }
+        }
+        if (hasArena) resetMatrixArena(&worker->arena);
+    }
+    if (hasArena) {
+        useMatrixArena(NULL);
+        freeMatrixArena(&worker->arena);
+    }
+    return NULL;
+}
+
+/* Runs every repetition of every job on a pool of `threads` workers and
+   reports the achieved rate on stderr. Returns 0 only if all graphs were written. */
+int runGenerationJobs(const GenerationJob *jobs, int count, int threads, const char *apiUrl) {
+    BatchShared shared;
+    shared.jobs = jobs;
+    shared.taskCount = 0;
+    shared.next = 0;
+    shared.baseSeed = (uint64_t)time(NULL);
+    shared.apiUrl = apiUrl;
+
+    int usesApi = 0, usesDedup = 0, usesBatch = 0;
+    shared.spans = malloc(count * sizeof(int));
+    if (!shared.spans) {
+        fprintf(stderr, "Memory allocation error for job pool\n");
+        return -2;
+    }
+    for (int i = 0; i < count; i++) {
+        int llm = jobs[i].type != GEN_RANDOM && jobs[i].type != GEN_USER && jobs[i].type != GEN_EDGE_LIST;
+        shared.taskCount += jobs[i].count;
+        usesApi |= llm;
+        usesDedup |= jobs[i].dedup != FINGERPRINT_NONE;
+        shared.spans[i] = 1;
+        if (llm && jobs[i].batch > 1) {
+            // Chat prompts that start with the vertex count can be sized too
+            int n = jobs[i].n > 0 ? jobs[i].n : (jobs[i].prompt ? atoi(jobs[i].prompt) : 0);
+            shared.spans[i] = llmBatchSize(n, jobs[i].maxTokens, jobs[i].batch);
+            usesBatch |= shared.spans[i] > 1;
+        }
+    }
+    if (threads > shared.taskCount) threads = shared.taskCount;
+    if (threads <= 0) {
+        free(shared.spans);
+        return 0;
+    }
+    // Sized for every task, so an insert never finds the set full
+    shared.seen.slots = NULL;
+    if (usesDedup && initFingerprintSet(&shared.seen, shared.taskCount) != 0) {
+        free(shared.spans);
+        return -2;
+    }
+
+    shared.tasks = malloc(shared.taskCount * sizeof(BatchTask));
+    BatchWorker *workers = calloc(threads, sizeof(BatchWorker));
+    pthread_t *handles = malloc(threads * sizeof(pthread_t));
+    if (!shared.tasks || !workers || !handles) {
+        fprintf(stderr, "Memory allocation error for job pool\n");
+        free(shared.tasks);
+        free(workers);
+        free(handles);
+        freeFingerprintSet(&shared.seen);
+        free(shared.spans);
+        return -2;
+    }
+    int t = 0;
+    for (int i = 0; i < count; i++) {
+        for (int rep = 0; rep < jobs[i].count; rep++) {
+            shared.tasks[t].job = i;
+            shared.tasks[t].rep = rep;
+            t++;
+        }
+    }
+
+    pthread_mutex_init(&shared.lock, NULL);
+    pthread_mutex_init(&shared.stdoutLock, NULL);
+    if (usesApi) curl_global_init(CURL_GLOBAL_ALL);
+
+    double start = now_seconds();
+    int started = 0;
+    for (; started < threads; started++) {
+        workers[started].shared = &shared;
+        workers[started].outBuffer = malloc(BATCH_OUT_BUFFER);
+        if (!workers[started].outBuffer ||
+            pthread_create(&handles[started], NULL, batch_worker, &workers[started]) != 0) {
+            fprintf(stderr, "Error starting worker thread %d\n", started);
+            free(workers[started].outBuffer);
+            break;
+        }
+    }
+    if (started == 0) {
+        fprintf(stderr, "No worker threads could be started\n");
+        if (usesApi) curl_global_cleanup();
+        pthread_mutex_destroy(&shared.lock);
+        pthread_mutex_destroy(&shared.stdoutLock);
+        free(shared.tasks);
+        free(workers);
+        free(handles);
+        freeFingerprintSet(&shared.seen);
+        free(shared.spans);
+        return -2;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    int produced = 0, failed = 0, duplicates = 0, requests = 0, llmGraphs = 0;
+    for (int i = 0; i < started; i++) {
+        produced += workers[i].produced;
+        failed += workers[i].failed;
+        duplicates += workers[i].duplicates;
+        requests += workers[i].requests;
+        llmGraphs += workers[i].llmGraphs;
+        if (workers[i].curl) curl_easy_cleanup(workers[i].curl);
+        free(workers[i].outBuffer);
+    }
+    fprintf(stderr, "Generated %d graphs (%d failed) in %.3f s with %d threads: %.1f graphs/s\n",
+            produced, failed, elapsed, started, elapsed > 0 ? produced / elapsed : 0.0);
+    if (usesDedup) {
+        fprintf(stderr, "Dropped %d duplicate graphs, %zu distinct fingerprints\n",
+                duplicates, atomic_load(&shared.seen.count));
+    }
+    if (usesBatch) {
+        fprintf(stderr, "%d model calls for %d graphs: %.2f graphs per call\n",
+                requests, llmGraphs, requests > 0 ? (double)llmGraphs / requests : 0.0);
+    }
+
+    if (usesApi) curl_global_cleanup();
+    pthread_mutex_destroy(&shared.lock);
+    pthread_mutex_destroy(&shared.stdoutLock);
+    free(shared.tasks);
+    free(workers);
+    free(handles);
+    freeFingerprintSet(&shared.seen);
+    free(shared.spans);
+    return failed == 0 ? 0 : 1;
+}
+
+static void batch_usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [--job \"key=value ...\"]... [--jobs file|-] [--threads n] [--api-url url]\n"
+        "Job keys: type=random|user|llm-random|llm-user|llm-chat|llm-extract|edgelist n= density= seed=\n"
+        "          count= edges=\"A->B, ...\" prompt=\"...\" in=path|- labels=string|numeric parsers=\n"
+        "          out=path|- format=matrix|dense|csrrg|edges dedup=none|exact|iso batch=n|auto max_tokens=\n",
+        prog);
+}
+
+/* Non-interactive entry point used by main() when options are given. */
+int runBatchCommand(int argc, char **argv) {
+    GenerationJob *jobs = NULL;
+    int count = 0;
+    int threads = BATCH_DEFAULT_THREADS;
+    const char *apiUrl = API_URL;
+    int status = 0;
+
+    for (int i = 1; i < argc && status == 0; i++) {
+        if (i + 1 >= argc) {
+            batch_usage(argv[0]);
+            status = 1;
+        } else if (strcmp(argv[i], "--job") == 0) {
+            GenerationJob *temp = realloc(jobs, (count + 1) * sizeof(GenerationJob));
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error during jobs realloc\n");
+                status = 1;
+            } else {
+                jobs = temp;
+                if (parseGenerationJob(argv[++i], &jobs[count]) != 0) {
+                    status = 1;
+                } else {
+                    count++;
+                }
+            }
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            if (loadGenerationJobs(argv[++i], &jobs, &count) != 0) status = 1;
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[++i]);
+            if (threads <= 0) {
+                fprintf(stderr, "Thread count must be positive\n");
+                status = 1;
+            }
+        } else if (strcmp(argv[i], "--api-url") == 0) {
+            apiUrl = argv[++i];
+        } else {
+            batch_usage(argv[0]);
+            status = 1;
+        }
+    }
+    if (status == 0 && count == 0) {
+        batch_usage(argv[0]);
+        status = 1;
+    }
+    if (status == 0) {
+        status = runGenerationJobs(jobs, count, threads, apiUrl);
+    }
+
+    for (int i = 0; i < count; i++) {
+        freeGenerationJob(&jobs[i]);
+    }
+    free(jobs);
+    return status;
+}
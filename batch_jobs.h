@@ -0,0 +1,49 @@
+#ifndef BATCH_JOBS_H
+#define BATCH_JOBS_H
+
+#include <stdint.h>
+#include "graph_fingerprint.h"
+
+typedef enum GenerationType {
+    GEN_RANDOM,       // Local random graph (generate_random_graph_r)
+    GEN_USER,         // Local graph from "A->B" edges (generate_user_defined_graph)
+    GEN_LLM_RANDOM,   // API mode 2
+    GEN_LLM_USER,     // API mode 1 with "n edges" prompt
+    GEN_LLM_CHAT,     // API mode 1 with a free-form prompt
+    GEN_LLM_EXTRACT,  // API mode 0 + local fill of the F cells
+    GEN_EDGE_LIST     // Edge list file read with readEdgeListFile
+} GenerationType;
+
+typedef enum OutputFormat {
+    OUTPUT_MATRIX,    // "0 1 ..." rows, as printed by the interactive mode
+    OUTPUT_DENSE,     // " [0. 1. ...]" rows plus "i - j" connections, as in graf.txt
+    OUTPUT_CSRRG,     // .csrrg layout readable by processCsrrgFile
+    OUTPUT_EDGES      // "src - dest" lines only, with the original labels for edge lists
+} OutputFormat;
+
+typedef struct GenerationJob {
+    GenerationType type;
+    int n;
+    double density;
+    uint64_t seed;
+    int hasSeed;
+    int count;        // Number of graphs produced by this job
+    char *edges;
+    char *prompt;
+    char *output;     // Path ("-" for stdout); "%d" is replaced by the repetition index
+    OutputFormat format;
+    char *input;      // Edge list path ("-" for stdin)
+    int labelFlags;   // EDGE_LIST_NUMERIC or 0
+    int parsers;      // Threads used to parse one edge list
+    FingerprintKind dedup;  // Graphs whose fingerprint was already seen are not written
+    int batch;        // Most repetitions of an LLM job packed into one request (1 = no batching)
+    int maxTokens;    // max_tokens of a batched request
+} GenerationJob;
+
+int parseGenerationJob(const char *spec, GenerationJob *job);
+int loadGenerationJobs(const char *fileName, GenerationJob **jobs, int *count);
+int runGenerationJobs(const GenerationJob *jobs, int count, int threads, const char *apiUrl);
+void freeGenerationJob(GenerationJob *job);
+int runBatchCommand(int argc, char **argv);
+
+#endif // BATCH_JOBS_H
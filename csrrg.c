@@ -3,326 +3,820 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "csrrg.h"
+#include "csrrg_output.h"
+#include "csrrg_pipeline.h"
+#include "csrrg_stats.h"
+#include "csrrg_validate.h"
 #include "graph_matrix.h"
+#include "stats.h"
 #include "utils.h"
 
-int processCsrrgFile(const char *fileName) {
-    FILE *f = fopen(fileName, "r");
-    if (!f) {
-        fprintf(stderr, "Error opening file %s\n", fileName);
-        return -4;
+int csrrgValidateInput = 0;
+
+/* Reads the next non-empty line into *line, growing it as needed, so rows
+   longer than any fixed buffer stay in one piece. Returns 0 at end of file. */
+int readCsrrgLine(FILE *f, char **line, size_t *capacity) {
+    if (!*line) {
+        *capacity = 65536;
+        *line = malloc(*capacity);
+        if (!*line) {
+            fprintf(stderr, "Memory allocation error for line buffer\n");
+            return -2;
+        }
+        STATS_ALLOC(*capacity);
     }
+    while (1) {
+        if (!fgets(*line, (int)*capacity, f)) return 0;
+        size_t len = strlen(*line);
+        while (len == *capacity - 1 && (*line)[len - 1] != '\n') {
+            char *temp = realloc(*line, *capacity * 2);
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error during line buffer realloc\n");
+                return -5;
+            }
+            *line = temp;
+            *capacity *= 2;
+            STATS_ALLOC(*capacity);
+            if (!fgets(*line + len, (int)(*capacity - len), f)) break;
+            len += strlen(*line + len);
+        }
+        STATS_ADD(STATS_BYTES_READ, len);
+        if (!isEmptyLine(*line)) return 1;
+    }
+}
 
-    /* --- Header Parsing (Lines 1-3) ---
-       Line 1: Maximum possible number of nodes in a row.
-       Line 2: A semicolon-separated list of node indices for each row.
-       Line 3: Pointers (cumulative indices) for the first index in each row (used to compute the count of nodes per row).
-    */
-    int maxRowNodes = 0;
-    char line[1048576];
-    char *line2 = NULL;  // For node indices (line 2)
-    char *headerLine3 = NULL;  // Temporary buffer for line 3 processing
+void freeCsrrgHeader(CsrrgHeader *header) {
+    free(header->line2);
+    free(header->line3);
+    free(header->rowCounts);
+    header->line2 = NULL;
+    header->line3 = NULL;
+    header->rowCounts = NULL;
+}
 
-    // Dynamic array for row counts (derived from differences in header line 3)
-    int capacityRows = 15;
-    int *rowCounts = malloc(capacityRows * sizeof(int));
-    if (!rowCounts) {
-        fprintf(stderr, "Memory allocation error for rowCounts\n");
-        fclose(f);
-        return -2;
-    }
-    int numRows = 0;
-    int vertexTotal = 0;   // Total number of indices (last cumulative value)
+/* --- Header Parsing (Lines 1-3) ---
+   Line 1: Maximum possible number of nodes in a row.
+   Line 2: A semicolon-separated list of node indices for each row.
+   Line 3: Pointers (cumulative indices) for the first index in each row (used to compute the count of nodes per row).
+*/
+int readCsrrgHeader(FILE *f, CsrrgHeader *header) {
+    memset(header, 0, sizeof(*header));
+    char *line = NULL;
+    size_t capacity = 0;
 
     // Read header lines (skip empty lines)
     int headerLineCount = 0;
-    while (headerLineCount < 3 && fgets(line, sizeof(line), f)) {
-        if (isEmptyLine(line))
-            continue;
+    int status;
+    while (headerLineCount < 3 && (status = readCsrrgLine(f, &line, &capacity)) > 0) {
         headerLineCount++;
         if (headerLineCount == 1) {
             // Line 1: maximum nodes in a row.
-            maxRowNodes = atoi(line);
+            header->maxRowNodes = atoi(line);
         } else if (headerLineCount == 2) {
             // Line 2: copy node indices list.
-            line2 = strdup(line);
-            if (!line2) {
+            header->line2 = strdup(line);
+            if (!header->line2) {
                 fprintf(stderr, "Memory allocation error for line2\n");
-                free(rowCounts);
-                fclose(f);
+                free(line);
                 return -2;
             }
-        } else if (headerLineCount == 3) {
+            STATS_ALLOC(strlen(line) + 1);
+        } else {
             // Line 3: pointers for first indices in each row.
-            headerLine3 = strdup(line);
-            if (!headerLine3) {
+            header->line3 = strdup(line);
+            if (!header->line3) {
                 fprintf(stderr, "Memory allocation error for headerLine3\n");
-                free(rowCounts);
-                free(line2);
-                fclose(f);
+                free(line);
+                freeCsrrgHeader(header);
                 return -2;
             }
-            // Process headerLine3: the tokens are cumulative indices.
-            int i = 0, prev = 0;
-            char *token = strtok(headerLine3, ";");
-            while (token) {
-                int current = atoi(token);
-                if (i > 0) {
-                    int count = current - prev;
-                    if (numRows >= capacityRows) {
-                        capacityRows *= 2;
-                        int *temp = realloc(rowCounts, capacityRows * sizeof(int));
-                        if (!temp) {
-                            fprintf(stderr, "Memory allocation error during rowCounts realloc\n");
-                            free(rowCounts);
-                            free(line2);
-                            free(headerLine3);
-                            fclose(f);
-                            return -5;
-                        }
-                        rowCounts = temp;
-                    }
-                    rowCounts[numRows++] = count;
-                }
-                prev = current;
-                token = strtok(NULL, ";");
-                i++;
-            }
-            vertexTotal = prev;  // Last cumulative value equals total indices.
-            free(headerLine3);
+            STATS_ALLOC(strlen(line) + 1);
         }
     }
+    free(line);
+    if (status < 0) {
+        freeCsrrgHeader(header);
+        return status;
+    }
     if (headerLineCount < 3) {
         fprintf(stderr, "Insufficient header lines in file\n");
-        free(rowCounts);
-        free(line2);
-        fclose(f);
+        freeCsrrgHeader(header);
         return -1;
     }
+    return 0;
+}
+
+/* Turns the cumulative pointers of line 3 into per-row counts and finds
+   the number of columns (highest index in line 2 plus one). */
+int buildCsrrgRowCounts(CsrrgHeader *header) {
+    // Dynamic array for row counts (derived from differences in header line 3)
+    int capacityRows = 15;
+    header->rowCounts = malloc(capacityRows * sizeof(int));
+    if (!header->rowCounts) {
+        fprintf(stderr, "Memory allocation error for rowCounts\n");
+        return -2;
+    }
+    header->numRows = 0;
+
+    // Process line 3: the tokens are cumulative indices.
+    char *saveptr;
+    int i = 0, prev = 0;
+    char *token = strtok_r(header->line3, ";", &saveptr);
+    while (token) {
+        int current = atoi(token);
+        if (i > 0) {
+            int count = current - prev;
+            if (header->numRows >= capacityRows) {
+                capacityRows *= 2;
+                int *temp = realloc(header->rowCounts, capacityRows * sizeof(int));
+                if (!temp) {
+                    fprintf(stderr, "Memory allocation error during rowCounts realloc\n");
+                    return -5;
+                }
+                header->rowCounts = temp;
+            }
+            header->rowCounts[header->numRows++] = count;
+        }
+        prev = current;
+        token = strtok_r(NULL, ";", &saveptr);
+        i++;
+    }
+    header->vertexTotal = prev;  // Last cumulative value equals total indices.
+    STATS_ADD(STATS_TOKENS_PARSED, i);
+    STATS_ALLOC(capacityRows * sizeof(int));
 
-    /* --- Build the Adjacency Matrix ---
-       We use:
-         - numRows: the number of rows (from header line 3 differences).
-         - maxRowNodes: used as the number of columns (assuming nodes are numbered 0 to maxRowNodes-1).
-    */
     // Calculate actual number of columns based on max node index
     int maxNodeIndex = -1;
-    char *line2CopyForMax = strdup(line2);
+    char *line2CopyForMax = strdup(header->line2);
     if (!line2CopyForMax) {
         fprintf(stderr, "Memory allocation error for line2CopyForMax\n");
-        free(rowCounts);
-        free(line2);
-        fclose(f);
         return -1;
     }
-    char *token = strtok(line2CopyForMax, ";");
+    STATS_ALLOC(strlen(header->line2) + 1);
+    long tokens = 0;
+    token = strtok_r(line2CopyForMax, ";", &saveptr);
     while (token) {
         int nodeIndex = atoi(token);
         if (nodeIndex > maxNodeIndex) {
             maxNodeIndex = nodeIndex;
         }
-        token = strtok(NULL, ";");
+        token = strtok_r(NULL, ";", &saveptr);
+        tokens++;
     }
+    STATS_ADD(STATS_TOKENS_PARSED, tokens);
     free(line2CopyForMax);
-    int columns = maxNodeIndex + 1;  // Actual columns needed
+    header->columns = maxNodeIndex + 1;  // Actual columns needed
+    return 0;
+}
 
-    AdjacencyMatrix adjacencyMatrix;
-    adjacencyMatrix.n = numRows;
-    adjacencyMatrix.matrix = malloc(numRows * sizeof(int *));
-    if (!adjacencyMatrix.matrix) {
+/* --- Build the Adjacency Matrix ---
+   We use:
+     - numRows: the number of rows (from header line 3 differences).
+     - columns: the number of columns (nodes are numbered 0 to columns-1).
+   For each row there are rowCounts[row] tokens in line 2; each token is an
+   index and the corresponding matrix cell is set to 1.
+*/
+int fillCsrrgMatrix(const CsrrgHeader *header, AdjacencyMatrix *adjacencyMatrix) {
+    int numRows = header->numRows;
+    int columns = header->columns;
+    *adjacencyMatrix = createAdjacencyMatrix(numRows, columns);
+    if (!adjacencyMatrix->matrix) {
         fprintf(stderr, "Error allocating memory for matrix\n");
-        free(rowCounts);
-        free(line2);
-        fclose(f);
         return -1;
     }
-    for (int i = 0; i < numRows; i++) {
-        adjacencyMatrix.matrix[i] = calloc(columns, sizeof(int));
-        if (!adjacencyMatrix.matrix[i]) {
-            fprintf(stderr, "Error allocating memory for matrix row %d\n", i);
-            for (int j = 0; j < i; j++) {
-                free(adjacencyMatrix.matrix[j]);
+
+    char *line2Copy = strdup(header->line2);
+    if (!line2Copy) {
+        fprintf(stderr, "Memory allocation error for line2Copy\n");
+        freeAdjacencyMatrix(adjacencyMatrix);
+        return -1;
+    }
+    STATS_ALLOC(strlen(header->line2) + 1);
+    long tokens = 0;
+    char *saveptr;
+    char *token = strtok_r(line2Copy, ";", &saveptr);
+    for (int row = 0; row < numRows; row++) {
+        int count = header->rowCounts[row];
+        for (int j = 0; j < count; j++) {
+            if (!token) break;  // error: not enough tokens
+            int nodeIndex = atoi(token);
+            if (nodeIndex >= 0 && nodeIndex < columns) {
+                adjacencyMatrix->matrix[row][nodeIndex] = 1;
             }
-            free(adjacencyMatrix.matrix);
-            free(rowCounts);
-            free(line2);
-            fclose(f);
-            return -1;
+            token = strtok_r(NULL, ";", &saveptr);
+            tokens++;
         }
     }
+    STATS_ADD(STATS_TOKENS_PARSED, tokens);
+    free(line2Copy);
+    return 0;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* The ones of the matrix fillCsrrgMatrix would build, straight from the
+   header as CSR: grid->n rows, every row's columns sorted and unique,
+   out-of-range indices dropped. Used by the sparse output formats. */
+int buildCsrrgGrid(const CsrrgHeader *header, SparseGraph *grid) {
+    int numRows = header->numRows;
+    int columns = header->columns;
+    long capacity = 1;
+    for (int row = 0; row < numRows; row++) {
+        if (header->rowCounts[row] > 0) capacity += header->rowCounts[row];
+    }
+    grid->n = numRows;
+    grid->m = 0;
+    grid->rowPtr = calloc((size_t)numRows + 1, sizeof(int));
+    grid->colIdx = malloc(capacity * sizeof(int));
+    char *line2Copy = strdup(header->line2);
+    if (!grid->rowPtr || !grid->colIdx || !line2Copy) {
+        fprintf(stderr, "Memory allocation error for grid\n");
+        free(line2Copy);
+        freeSparseGraph(grid);
+        return -2;
+    }
+    STATS_ALLOC(((size_t)numRows + 1 + capacity) * sizeof(int) + strlen(header->line2) + 1);
+
+    long tokens = 0;
+    int m = 0;
+    char *saveptr;
+    char *token = strtok_r(line2Copy, ";", &saveptr);
+    for (int row = 0; row < numRows; row++) {
+        int start = m;
+        for (int j = 0; j < header->rowCounts[row] && token; j++) {
+            int nodeIndex = atoi(token);
+            if (nodeIndex >= 0 && nodeIndex < columns) {
+                grid->colIdx[m++] = nodeIndex;
+            }
+            token = strtok_r(NULL, ";", &saveptr);
+            tokens++;
+        }
+        // Same cells as the dense matrix: in column order, each once
+        qsort(grid->colIdx + start, m - start, sizeof(int), compare_ints);
+        int unique = start;
+        for (int k = start; k < m; k++) {
+            if (k == start || grid->colIdx[k] != grid->colIdx[unique - 1]) {
+                grid->colIdx[unique++] = grid->colIdx[k];
+            }
+        }
+        m = unique;
+        grid->rowPtr[row + 1] = m;
+    }
+    grid->m = m;
+    STATS_ADD(STATS_TOKENS_PARSED, tokens);
+    free(line2Copy);
+    return 0;
+}
+
+/* Appends one edge to section->text in section->style, growing it as
+   needed: "src - dest\n", 1-based "src dest\n" or two little-endian int32. */
+static int append_edge(CsrrgSection *section, int src, int dest) {
+    if (section->length + 48 > section->capacity) {
+        size_t capacity = section->capacity ? section->capacity * 2 : 4096;
+        char *temp = realloc(section->text, capacity);
+        if (!temp) {
+            fprintf(stderr, "Memory allocation error for edge section output\n");
+            return -5;
+        }
+        section->text = temp;
+        section->capacity = capacity;
+        STATS_ALLOC(capacity);
+    }
+    char *out = section->text + section->length;
+    if (section->style == CSRRG_EDGES_BINARY) {
+        out = putInt32LE(out, (uint32_t)src);
+        out = putInt32LE(out, (uint32_t)dest);
+    } else if (section->style == CSRRG_EDGES_MTX) {
+        out = formatInt(out, (long long)src + 1);
+        *out++ = ' ';
+        out = formatInt(out, (long long)dest + 1);
+        *out++ = '\n';
+    } else {
+        out = formatInt(out, src);
+        memcpy(out, " - ", 3);
+        out = formatInt(out + 3, dest);
+        *out++ = '\n';
+    }
+    section->length = out - section->text;
+    return 0;
+}
+
+/* CSRRG_EDGES_SECTION: the edges are formatted as int32 pairs first, then
+   every run of edges with the same source becomes one group. The pointer
+   line ends with the total, so the converter reads the last group too.
+   A section left without edges produces no text. */
+static int format_section_lines(CsrrgSection *section) {
+    section->style = CSRRG_EDGES_BINARY;
+    int status = formatCsrrgEdgeSection(section);
+    section->style = CSRRG_EDGES_SECTION;
+    long edges = section->edges;
+    if (status != 0 || edges == 0) {
+        section->length = 0;
+        return status;
+    }
+    // At most two 11-byte tokens and one pointer per edge
+    size_t capacity = (size_t)edges * 36 + 16;
+    char *lines = malloc(capacity);
+    if (!lines) {
+        fprintf(stderr, "Memory allocation error for edge section output\n");
+        return -2;
+    }
+    STATS_ALLOC(capacity);
+    const char *pairs = section->text;
+    char *out = lines;
+    for (long e = 0; e < edges; e++) {
+        uint32_t src = getInt32LE(pairs + 8 * e);
+        if (e == 0 || src != getInt32LE(pairs + 8 * (e - 1))) {
+            if (e > 0) *out++ = ';';
+            out = formatInt(out, src);
+        }
+        *out++ = ';';
+        out = formatInt(out, getInt32LE(pairs + 8 * e + 4));
+    }
+    memcpy(out, "\n0", 2);
+    out += 2;
+    long tokens = 0;
+    for (long e = 0; e < edges; e++) {
+        uint32_t src = getInt32LE(pairs + 8 * e);
+        tokens += (e == 0 || src != getInt32LE(pairs + 8 * (e - 1))) ? 2 : 1;
+        if (e + 1 == edges || getInt32LE(pairs + 8 * (e + 1)) != src) {
+            *out++ = ';';
+            out = formatInt(out, tokens);
+        }
+    }
+    *out++ = '\n';
+    free(section->text);
+    section->text = lines;
+    section->capacity = capacity;
+    section->length = out - lines;
+    return 0;
+}
+
+/* --- Format one edge groups section ---
+   edgeLine:    list of nodes forming groups (edges).
+   pointerLine: pointers to the first node in each group.
+   Both lines are tokenized in place. Every edge is appended to
+   section->text (as "src - dest" unless section->style says otherwise);
+   edges and tokens are counted.
+*/
+int formatCsrrgEdgeSection(CsrrgSection *section) {
+    if (section->style == CSRRG_EDGES_SECTION) return format_section_lines(section);
+    section->length = 0;
+    section->edges = 0;
+    section->tokens = 0;
+    section->groups = 0;
+
+    /* Parse pointerLine to get connection counts for this section.
+       The pointers are cumulative indices for the tokens in edgeLine.
+    */
+    int capacityConnGroups = 15;
+    int *connCounts = malloc(capacityConnGroups * sizeof(int));
+    if (!connCounts) {
+        fprintf(stderr, "Memory allocation error for connCounts\n");
+        return -2;
+    }
+    int numConnGroups = 0;
+    char *saveptr;
+    int i = 0, prev = 0;
+    char *token = strtok_r(section->pointerLine, ";", &saveptr);
+    while (token) {
+        int current = atoi(token);
+        if (i > 0) {
+            if (numConnGroups >= capacityConnGroups) {
+                capacityConnGroups *= 2;
+                int *temp = realloc(connCounts, capacityConnGroups * sizeof(int));
+                if (!temp) {
+                    free(connCounts);
+                    return -5;
+                }
+                connCounts = temp;
+            }
+            connCounts[numConnGroups++] = current - prev;
+        }
+        prev = current;
+        token = strtok_r(NULL, ";", &saveptr);
+        i++;
+    }
+    section->tokens += i;
 
-    /* Process line2: fill the matrix.
-       For each row, there are rowCounts[row] tokens.
-       Each token is an index; set the corresponding matrix cell to 1.
+    /* Process edgeLine.
+       For each connection group (0..numConnGroups-1), read connCounts[group] tokens.
+       The first token in each group is the source node; the subsequent tokens are destination nodes.
     */
-    if (line2 != NULL) {
-        char *line2Copy = strdup(line2);
-        if (!line2Copy) {
-            fprintf(stderr, "Memory allocation error for line2Copy\n");
-            freeAdjacencyMatrix(&adjacencyMatrix);
-            free(rowCounts);
-            free(line2);
+    int status = 0;
+    token = strtok_r(section->edgeLine, ";", &saveptr);
+    for (int group = 0; token && group < numConnGroups && status == 0; group++) {
+        int connections = connCounts[group];
+        int src = -1;
+        section->groups += connections > 0;
+        for (int k = 0; k < connections && token; k++) {
+            int value = atoi(token);
+            if (k == 0) {
+                src = value;
+            } else if (!section->relabel || (section->relabel[src] >= 0 && section->relabel[value] >= 0)) {
+                status = section->relabel ? append_edge(section, section->relabel[src], section->relabel[value])
+                                          : append_edge(section, src, value);
+                if (status != 0) break;
+                section->edges++;
+                if (section->stats && (status = csrrgStatsAddEdge(section->stats, src, value)) != 0) break;
+            }
+            token = strtok_r(NULL, ";", &saveptr);
+            section->tokens++;
+        }
+    }
+    free(connCounts);
+    return status;
+}
+
+/* Reads the next edge section (a pair of non-empty lines) into
+   section->edgeLine and section->pointerLine. Returns 1 on success, 0 at
+   end of file, -1 for a trailing edge line without its pointer line, or
+   another negative error code. */
+int readCsrrgEdgeSection(FILE *f, char **line, size_t *capacity, CsrrgSection *section) {
+    // line 4 of a section
+    int got = readCsrrgLine(f, line, capacity);
+    if (got <= 0) return got;
+    char *edgeLine = strdup(*line);
+    if (!edgeLine) {
+        fprintf(stderr, "Memory allocation error for edge line\n");
+        return -2;
+    }
+    // line 5 of the section
+    got = readCsrrgLine(f, line, capacity);
+    if (got <= 0) {
+        free(edgeLine);
+        if (got == 0) {
+            fprintf(stderr, "Incomplete edge section found\n");
+            return -1;
+        }
+        return got;
+    }
+    char *pointerLine = strdup(*line);
+    if (!pointerLine) {
+        fprintf(stderr, "Memory allocation error for pointer line\n");
+        free(edgeLine);
+        return -2;
+    }
+    section->bytes = strlen(edgeLine) + strlen(pointerLine);
+    STATS_ALLOC(section->bytes + 2);
+    section->edgeLine = edgeLine;
+    section->pointerLine = pointerLine;
+    return 1;
+}
+
+void freeCsrrgSection(CsrrgSection *section) {
+    free(section->edgeLine);
+    free(section->pointerLine);
+    free(section->text);
+    section->edgeLine = NULL;
+    section->pointerLine = NULL;
+    section->text = NULL;
+    section->length = section->capacity = 0;
+}
+
+/* --- Process one or more edge groups sections ---
+   After the header (3 lines), the file contains pairs of non-empty lines
+   (see formatCsrrgEdgeSection). Each edge is printed to result as
+   "src - dest". Returns the number of edges printed, or a negative error code.
+*/
+long printCsrrgEdgeSections(FILE *f, FILE *result) {
+    char *line = NULL;
+    size_t capacity = 0;
+    long edgesPrinted = 0;
+    long tokens = 0;
+    long written = 0;
+    int status;
+    CsrrgSection section = {0};
+
+    while ((status = readCsrrgEdgeSection(f, &line, &capacity, &section)) > 0) {
+        status = formatCsrrgEdgeSection(&section);
+        free(section.edgeLine);
+        free(section.pointerLine);
+        section.edgeLine = section.pointerLine = NULL;
+        tokens += section.tokens;
+        if (status != 0) break;
+        written += fwrite(section.text, 1, section.length, result);
+        edgesPrinted += section.edges;
+    }
+
+    freeCsrrgSection(&section);
+    free(line);
+    if (status == -1) status = 0;  // An incomplete last section is ignored
+    STATS_ADD(STATS_TOKENS_PARSED, tokens);
+    STATS_ADD(STATS_EDGES_EMITTED, edgesPrinted);
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    return status < 0 ? status : edgesPrinted;
+}
+
+/* Every output format except dense: the matrix part is written straight
+   from the CSR grid, without building the dense matrix, and the pipeline's
+   sections follow. Consumes the pipeline. */
+static long write_sparse_output(const CsrrgHeader *header, CsrrgPipeline *pipeline) {
+    SparseGraph grid;
+    uint64_t phase = statsPhaseBegin();
+    int status = buildCsrrgGrid(header, &grid);
+    statsPhaseEnd(STATS_MATRIX_FILL, phase);
+    if (status != 0) {
+        cancelCsrrgPipeline(pipeline);
+        return status;
+    }
+    CsrrgOutput output;
+    status = openCsrrgOutput(&output, csrrgOutputFormat, NULL);
+    if (status != 0) {
+        cancelCsrrgPipeline(pipeline);
+        freeSparseGraph(&grid);
+        return status;
+    }
+    // Reported as dense_print: it is the matrix part of the output
+    phase = statsPhaseBegin();
+    status = writeCsrrgGrid(&output, &grid, header->columns, header->vertexTotal);
+    statsPhaseEnd(STATS_DENSE_PRINT, phase);
+    freeSparseGraph(&grid);
+
+    long edges = status;
+    if (status == 0) {
+        edges = drainCsrrgPipeline(pipeline, csrrgEdgeWriter(&output));
+    } else {
+        cancelCsrrgPipeline(pipeline);
+    }
+    status = closeCsrrgOutput(&output, edges);
+    return edges < 0 ? edges : status;
+}
+
+/* Prints the statistics of a conversion that succeeded with the pipeline,
+   then frees them. */
+static void finish_graph_stats(const char *fileName, CsrrgGraphStats *stats, int printable) {
+    if (!stats) return;
+    if (printable) {
+        printCsrrgGraphStats(stdout, fileName, stats, csrrgStatsMode == 2);
+    }
+    freeCsrrgGraphStats(stats);
+}
+
+/* Converts fileName into graf.txt (or the file of csrrgOutputFormat). Once the header is read, the edge
+   sections are read and parsed by a CsrrgPipeline while the matrix is
+   built and written, so reading, parsing and writing overlap. With
+   csrrgValidateInput set the header and every section are validated on
+   the way; as the output is only renamed into place once the conversion
+   succeeds, invalid input leaves no partial graf.txt behind.
+   With csrrgStatsMode set the pipeline workers also gather the graph's
+   statistics from the edges they parse, printed once the conversion is done. */
+int processCsrrgFile(const char *fileName) {
+    FILE *f = fopen(fileName, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", fileName);
+        return -4;
+    }
+
+    CsrrgHeader header;
+    uint64_t phase = statsPhaseBegin();
+    int status = readCsrrgHeader(f, &header);
+    statsPhaseEnd(STATS_HEADER_PARSE, phase);
+    if (status != 0) {
+        fclose(f);
+        return status;
+    }
+    int vertexLimit = -1;
+    if (csrrgValidateInput) {
+        CsrrgValidation report;
+        if (validateCsrrgHeader(&header, &report) != 0) {
+            freeCsrrgHeader(&header);
             fclose(f);
             return -1;
         }
-        char *token = strtok(line2Copy, ";");
-        for (int row = 0; row < numRows; row++) {
-            int count = rowCounts[row];
-            for (int j = 0; j < count; j++) {
-                if (!token) break;  // error: not enough tokens
-                int nodeIndex = atoi(token);
-                if (nodeIndex >= 0 && nodeIndex < columns) {
-                    adjacencyMatrix.matrix[row][nodeIndex] = 1;
-                }
-                token = strtok(NULL, ";");
-            }
+        vertexLimit = report.vertexTotal;
+    }
+    CsrrgGraphStats graphStats;
+    CsrrgGraphStats *stats = NULL;
+    if (csrrgStatsMode) {
+        initCsrrgGraphStats(&graphStats, &header);
+        stats = &graphStats;
+    }
+    CsrrgPipeline *pipeline = startCsrrgPipeline(f, CSRRG_PIPELINE_WORKERS, vertexLimit, NULL,
+                                                 csrrgEdgeStyle(csrrgOutputFormat), stats);
+    if (stats && !pipeline) {
+        fprintf(stderr, "Graph statistics need the conversion pipeline, none are collected\n");
+    }
+
+    phase = statsPhaseBegin();
+    status = buildCsrrgRowCounts(&header);
+    statsPhaseEnd(STATS_ROW_COUNTS, phase);
+    if (status == 0 && stats) setCsrrgStatsHeader(stats, &header);
+    if (status == 0 && csrrgOutputFormat != CSRRG_OUT_DENSE) {
+        long edges = -2;
+        if (pipeline) {
+            edges = write_sparse_output(&header, pipeline);
+        } else {
+            fprintf(stderr, "Could not start the conversion pipeline\n");
         }
-        free(line2Copy);
-        free(line2);
+        finish_graph_stats(fileName, stats, edges >= 0);
+        freeCsrrgHeader(&header);
+        fclose(f);
+        return edges < 0 ? (int)edges : 0;
+    }
+    AdjacencyMatrix adjacencyMatrix = {NULL, 0, 0};
+    if (status == 0) {
+        phase = statsPhaseBegin();
+        status = fillCsrrgMatrix(&header, &adjacencyMatrix);
+        statsPhaseEnd(STATS_MATRIX_FILL, phase);
     }
 
     /* --- Open output file ---
        All printing is done before closing.
     */
-    FILE *result = fopen("graf.txt", "w");
-    if (!result) {
-        fprintf(stderr, "Error opening output file graf.txt\n");
-        freeAdjacencyMatrix(&adjacencyMatrix);
-        free(rowCounts);
+    CsrrgOutput output;
+    FILE *result = NULL;
+    if (status == 0) {
+        status = openCsrrgOutput(&output, CSRRG_OUT_DENSE, NULL);
+        result = output.main.file;
+    }
+    if (status != 0) {
+        if (pipeline) cancelCsrrgPipeline(pipeline);
+        finish_graph_stats(fileName, stats, 0);
+        if (adjacencyMatrix.matrix) freeAdjacencyMatrix(&adjacencyMatrix);
+        freeCsrrgHeader(&header);
         fclose(f);
-        return -3;
+        return status;
     }
-    // Print the adjacency matrix once.
-    printAdjacencyMatrixToFile(result, &adjacencyMatrix, columns);
 
-    /* --- Process one or more edge groups sections ---
-       After the header (3 lines), the file contains pairs of non-empty lines:
-         First of the pair (edgeLine):  list of nodes forming groups (edges).
-         Second of the pair (pointerLine): pointers to the first node in each group.
-    */
-    while (1) {
-        char *edgeLine = NULL;
-        char *pointerLine = NULL;
-        // line 4 of a section
-        while (fgets(line, sizeof(line), f)) {
-            if (!isEmptyLine(line)) {
-                edgeLine = strdup(line);
-                break;
+    long edges;
+    if (pipeline) {
+        edges = finishCsrrgPipeline(pipeline, result, &adjacencyMatrix, header.columns);
+    } else {
+        // Could not start the threads, do it in order on this one (sections unvalidated)
+        phase = statsPhaseBegin();
+        printAdjacencyMatrixToFile(result, &adjacencyMatrix, header.columns);
+        statsPhaseEnd(STATS_DENSE_PRINT, phase);
+        phase = statsPhaseBegin();
+        edges = printCsrrgEdgeSections(f, result);
+        statsPhaseEnd(STATS_EDGE_SECTIONS, phase);
+    }
+
+    finish_graph_stats(fileName, stats, pipeline && edges >= 0);
+
+    //Cleanup
+    status = closeCsrrgOutput(&output, edges);
+    fclose(f);
+    freeCsrrgHeader(&header);
+    freeAdjacencyMatrix(&adjacencyMatrix);
+
+    return edges < 0 ? (int)edges : status;
+}
+
+/* Writes a matrix in the layout processCsrrgFile reads:
+     Line 1: number of columns.
+     Line 2: column indices of the ones, row by row.
+     Line 3: cumulative pointers into line 2 (one per row plus the leading 0).
+     Lines 4-5: one edge section, a group "src;dest;dest..." per row with edges.
+*/
+int writeCsrrgFile(FILE *file, const AdjacencyMatrix *matrix) {
+    int edges = 0;
+    fprintf(file, "%d\n", matrix->n);
+    for (int i = 0; i < matrix->n; i++) {
+        for (int j = 0; j < matrix->n; j++) {
+            if (matrix->matrix[i][j] == 1) {
+                fprintf(file, edges++ ? ";%d" : "%d", j);
             }
         }
-        if (!edgeLine) {
-            // No more edge sections.
-            break;
+    }
+    // Blank lines are skipped by the reader, so an edgeless line 2 needs a token separator
+    fprintf(file, edges ? "\n" : ";\n");
+
+    fprintf(file, "0");
+    int total = 0;
+    for (int i = 0; i < matrix->n; i++) {
+        for (int j = 0; j < matrix->n; j++) {
+            total += matrix->matrix[i][j] == 1;
         }
-        // line 5 of the section
-        while (fgets(line, sizeof(line), f)) {
-            if (!isEmptyLine(line)) {
-                pointerLine = strdup(line);
-                break;
+        fprintf(file, ";%d", total);
+    }
+    fprintf(file, "\n");
+    if (edges == 0) {
+        return ferror(file) ? -3 : 0;
+    }
+
+    int tokens = 0;
+    for (int i = 0; i < matrix->n; i++) {
+        int first = 1;
+        for (int j = 0; j < matrix->n; j++) {
+            if (matrix->matrix[i][j] != 1) continue;
+            if (first) {
+                fprintf(file, tokens++ ? ";%d" : "%d", i);
+                first = 0;
             }
+            fprintf(file, ";%d", j);
+            tokens++;
         }
-        if (!pointerLine) {
-            fprintf(stderr, "Incomplete edge section found\n");
-            free(edgeLine);
-            break;
-        }
-
-        /* Parse pointerLine to get connection counts for this section.
-           The pointers are cumulative indices for the tokens in edgeLine.
-        */
-        int capacityConnGroups = 15;
-        int *connCounts = malloc(capacityConnGroups * sizeof(int));
-        if (!connCounts) {
-            fprintf(stderr, "Memory allocation error for connCounts\n");
-            free(edgeLine);
-            free(pointerLine);
-            break;
+    }
+    fprintf(file, "\n0");
+    tokens = 0;
+    for (int i = 0; i < matrix->n; i++) {
+        int count = 0;
+        for (int j = 0; j < matrix->n; j++) {
+            count += matrix->matrix[i][j] == 1;
         }
-        int numConnGroups = 0;
-        {
-            int i = 0, prev = 0;
-            char *pointerCopy = strdup(pointerLine);
-            if (!pointerCopy) {
-                free(edgeLine);
-                free(pointerLine);
-                free(connCounts);
-                break;
-            }
-            char *token = strtok(pointerCopy, ";");
-            while (token) {
-                int current = atoi(token);
-                if (i > 0) {
-                    int count = current - prev;
-                    if (numConnGroups >= capacityConnGroups) {
-                        capacityConnGroups *= 2;
-                        int *temp = realloc(connCounts, capacityConnGroups * sizeof(int));
-                        if (!temp) {
-                            free(connCounts);
-                            free(pointerCopy);
-                            free(edgeLine);
-                            free(pointerLine);
-                            fclose(result);
-                            fclose(f);
-                            freeAdjacencyMatrix(&adjacencyMatrix);
-                            free(rowCounts);
-                            return -5;
-                        }
-                        connCounts = temp;
-                    }
-                    connCounts[numConnGroups] = count;
-                    numConnGroups++;
-                }
-                prev = current;
-                token = strtok(NULL, ";");
-                i++;
-            }
-            free(pointerCopy);
+        if (count > 0) {
+            tokens += count + 1;
+            fprintf(file, ";%d", tokens);
         }
+    }
+    fprintf(file, "\n");
+    return ferror(file) ? -3 : 0;
+}
+
+// Buffered ";value" tokens for writeSparseCsrrgFile, which can write hundreds of MB
+typedef struct TokenWriter {
+    FILE *file;
+    char data[1 << 16];
+    size_t length;
+} TokenWriter;
+
+static void put_token(TokenWriter *writer, int separator, long long value) {
+    if (writer->length + 24 > sizeof(writer->data)) {
+        fwrite(writer->data, 1, writer->length, writer->file);
+        writer->length = 0;
+    }
+    char *out = writer->data + writer->length;
+    if (separator) *out++ = (char)separator;
+    writer->length = formatInt(out, value) - writer->data;
+}
+
+static void put_text(TokenWriter *writer, const char *text) {
+    size_t length = strlen(text);
+    if (writer->length + length > sizeof(writer->data)) {
+        fwrite(writer->data, 1, writer->length, writer->file);
+        writer->length = 0;
+    }
+    memcpy(writer->data + writer->length, text, length);
+    writer->length += length;
+}
+
+// Lines 2 and 3: the column of every entry, then the row pointers
+static void put_grid_lines(TokenWriter *writer, const SparseGraph *graph) {
+    for (int k = 0; k < graph->m; k++) {
+        put_token(writer, k ? ';' : 0, graph->colIdx[k]);
+    }
+    put_text(writer, graph->m ? "\n" : ";\n");
+    for (int i = 0; i <= graph->n; i++) {
+        put_token(writer, i ? ';' : 0, graph->rowPtr[i]);
+    }
+    put_text(writer, "\n");
+}
+
+static TokenWriter *new_token_writer(FILE *file) {
+    TokenWriter *writer = malloc(sizeof(TokenWriter));
+    if (!writer) {
+        fprintf(stderr, "Memory allocation error for csrrg output buffer\n");
+        return NULL;
+    }
+    writer->file = file;
+    writer->length = 0;
+    return writer;
+}
 
-        /* Process edgeLine.
-           For each connection group (0..numConnGroups-1), read connCounts[group] tokens.
-           The first token in each group is the source node; the subsequent tokens are destination nodes.
-           Each edge is printed in the format "src - dest".
-        */
-        {
-            char *edgeCopy = strdup(edgeLine);
-            if (!edgeCopy) {
-                free(edgeLine);
-                free(pointerLine);
-                free(connCounts);
-                break;
+int writeSparseCsrrgGrid(FILE *file, const SparseGraph *graph) {
+    TokenWriter *writer = new_token_writer(file);
+    if (!writer) return -2;
+    put_grid_lines(writer, graph);
+    fwrite(writer->data, 1, writer->length, file);
+    free(writer);
+    return ferror(file) ? -3 : 0;
+}
+
+// Same layout as writeCsrrgFile, written straight from CSR arrays
+int writeSparseCsrrgFile(FILE *file, const SparseGraph *graph) {
+    TokenWriter *writer = new_token_writer(file);
+    if (!writer) return -2;
+    put_token(writer, 0, graph->n);
+    put_text(writer, "\n");
+    put_grid_lines(writer, graph);
+
+    if (graph->m > 0) {
+        int tokens = 0;
+        for (int i = 0; i < graph->n; i++) {
+            if (graph->rowPtr[i] == graph->rowPtr[i + 1]) continue;
+            put_token(writer, tokens++ ? ';' : 0, i);
+            for (int k = graph->rowPtr[i]; k < graph->rowPtr[i + 1]; k++) {
+                put_token(writer, ';', graph->colIdx[k]);
+                tokens++;
             }
-            char *token = strtok(edgeCopy, ";");
-            int group = 0;
-            while (token && group < numConnGroups) {
-                int connections = connCounts[group];
-                int src = -1;
-                for (int k = 0; k < connections; k++) {
-                    if (!token)
-                        break;
-                    int value = atoi(token);
-                    if (k == 0) {
-                        src = value;
-                    } else {
-                        int dest = value;
-                        fprintf(result, "%d - %d\n", src, dest);
-                    }
-                    token = strtok(NULL, ";");
-                }
-                group++;
+        }
+        put_text(writer, "\n0");
+        tokens = 0;
+        for (int i = 0; i < graph->n; i++) {
+            int count = graph->rowPtr[i + 1] - graph->rowPtr[i];
+            if (count > 0) {
+                tokens += count + 1;
+                put_token(writer, ';', tokens);
             }
-            free(edgeCopy);
         }
-        free(edgeLine);
-        free(pointerLine);
-        free(connCounts);
+        put_text(writer, "\n");
     }
-
-    //Cleanup
-    fclose(result);
-    fclose(f);
-    free(rowCounts);
-    freeAdjacencyMatrix(&adjacencyMatrix);
-
-    return 0;
+    fwrite(writer->data, 1, writer->length, file);
+    free(writer);
+    return ferror(file) ? -3 : 0;
 }
@@ -1,7 +1,70 @@
 #ifndef CSRRG_H
 #define CSRRG_H
 
+#include <stdio.h>
+#include "graph_matrix.h"
+#include "sparse_graph.h"
+
+// Header lines of a .csrrg file and what is derived from them
+typedef struct CsrrgHeader {
+    int maxRowNodes;  // Line 1
+    char *line2;      // Node indices of every row
+    char *line3;      // Cumulative row pointers
+    int *rowCounts;   // Indices per row, from line 3
+    int numRows;
+    int vertexTotal;  // Last row pointer
+    int columns;      // Highest index in line 2 + 1
+} CsrrgHeader;
+
+struct CsrrgStatsAccumulator;
+
+// How formatCsrrgEdgeSection writes each edge
+typedef enum CsrrgEdgeStyle {
+    CSRRG_EDGES_TEXT,    // "src - dest", as in graf.txt
+    CSRRG_EDGES_MTX,     // "src dest", 1-based, Matrix Market entries
+    CSRRG_EDGES_BINARY,  // src and dest as little-endian int32
+    CSRRG_EDGES_SECTION  // A new edge section: "src;dest;..." groups and their pointer line
+} CsrrgEdgeStyle;
+
+// One edge section: the two input lines and the "src - dest" text made from them
+typedef struct CsrrgSection {
+    char *edgeLine;
+    char *pointerLine;
+    char *text;
+    size_t length;
+    size_t capacity;
+    long edges;
+    long tokens;
+    long groups;      // Non-empty groups parsed
+    size_t bytes;     // Length of the two input lines, line ends included
+    CsrrgEdgeStyle style;
+    int index;        // 1-based position in the file, set by the pipeline
+    const int *relabel;  // If set: new id of every vertex, -1 drops its edges
+    struct CsrrgStatsAccumulator *stats;  // If set: every edge parsed is counted there
+    int status;       // Result of validation and formatCsrrgEdgeSection in the pipeline
+} CsrrgSection;
+
+// Set by --validate: processCsrrgFile rejects structurally invalid input
+extern int csrrgValidateInput;
+
 int processCsrrgFile(const char *fileName);
 
+// Stages of processCsrrgFile, in order
+int readCsrrgLine(FILE *f, char **line, size_t *capacity);
+int readCsrrgHeader(FILE *f, CsrrgHeader *header);
+int buildCsrrgRowCounts(CsrrgHeader *header);
+int fillCsrrgMatrix(const CsrrgHeader *header, AdjacencyMatrix *matrix);
+int buildCsrrgGrid(const CsrrgHeader *header, SparseGraph *grid);
+long printCsrrgEdgeSections(FILE *f, FILE *result);
+int readCsrrgEdgeSection(FILE *f, char **line, size_t *capacity, CsrrgSection *section);
+int formatCsrrgEdgeSection(CsrrgSection *section);
+void freeCsrrgSection(CsrrgSection *section);
+void freeCsrrgHeader(CsrrgHeader *header);
+
+int writeCsrrgFile(FILE *file, const AdjacencyMatrix *matrix);
+int writeSparseCsrrgFile(FILE *file, const SparseGraph *graph);
+// Lines 2 and 3 of writeSparseCsrrgFile only, for a header whose edge sections are kept
+int writeSparseCsrrgGrid(FILE *file, const SparseGraph *graph);
+
 #endif //CSRRG_H
 
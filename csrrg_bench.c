@@ -0,0 +1,435 @@
+/* Stage-by-stage benchmark of the .csrrg -> graf.txt conversion.
+ *
+ * Runs the stages of processCsrrgFile (header parse, row counts, matrix
+ * fill, dense print, edge sections) on each input several times, keeps the
+ * fastest time of every stage and prints one JSON document with MB/s,
+ * edges/s and peak RSS per input (each input runs in a child process), plus the time of the whole pipelined
+ * conversion that processCsrrgFile uses. Synthetic inputs of the given scales are
+ * generated in memory with writeSparseCsrrgFile.
+ *
+ * Usage: csrrg_bench [--repeat n] [--scale rows[,rows...]] [--out file.json]
+ *                    [--baseline old.json [--threshold pct]] [file.csrrg ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "csrrg.h"
+#include "csrrg_pipeline.h"
+#include "graph_generator.h"
+#include "graph_matrix.h"
+#include "sparse_graph.h"
+
+#define BENCH_STAGES 5
+#define BENCH_MAX_SCALES 16
+#define BENCH_SYNTHETIC_DEGREE 8
+
+static const char *stageNames[BENCH_STAGES] = {
+    "header_parse", "row_counts", "matrix_fill", "dense_print", "edge_sections"
+};
+
+static const char *defaultInputs[] = {
+    "graf.csrrg", "graf1.csrrg", "graf2.csrrg", "graf3.csrrg",
+    "graf4.csrrg", "graf5.csrrg", "graf6.csrrg"
+};
+
+typedef struct BenchResult {
+    char name[256];
+    long inputBytes;
+    long outputBytes;
+    int rows;
+    int columns;
+    long matrixEdges;   // Ones set from line 2
+    long sectionEdges;  // "src - dest" lines from the edge sections
+    double stages[BENCH_STAGES];
+    double total;
+    double pipelined;   // Whole conversion through CsrrgPipeline
+    long peakRssKb;
+} BenchResult;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* One timed conversion of `input` into `output`; fills the per-stage times. */
+static int run_once(FILE *input, FILE *output, BenchResult *result, double times[BENCH_STAGES]) {
+    rewind(input);
+    rewind(output);
+
+    double t0 = now_seconds();
+    CsrrgHeader header;
+    int status = readCsrrgHeader(input, &header);
+    if (status != 0) return status;
+    double t1 = now_seconds();
+
+    status = buildCsrrgRowCounts(&header);
+    if (status != 0) {
+        freeCsrrgHeader(&header);
+        return status;
+    }
+    double t2 = now_seconds();
+
+    AdjacencyMatrix matrix;
+    status = fillCsrrgMatrix(&header, &matrix);
+    if (status != 0) {
+        freeCsrrgHeader(&header);
+        return status;
+    }
+    double t3 = now_seconds();
+
+    printAdjacencyMatrixToFile(output, &matrix, header.columns);
+    fflush(output);
+    double t4 = now_seconds();
+
+    long sectionEdges = printCsrrgEdgeSections(input, output);
+    fflush(output);
+    double t5 = now_seconds();
+
+    times[0] = t1 - t0;
+    times[1] = t2 - t1;
+    times[2] = t3 - t2;
+    times[3] = t4 - t3;
+    times[4] = t5 - t4;
+
+    result->rows = header.numRows;
+    result->columns = header.columns;
+    result->matrixEdges = 0;
+    for (int i = 0; i < matrix.n; i++) {
+        for (int j = 0; j < header.columns; j++) {
+            result->matrixEdges += matrix.matrix[i][j];
+        }
+    }
+    result->sectionEdges = sectionEdges > 0 ? sectionEdges : 0;
+    result->outputBytes = ftell(output);
+
+    freeAdjacencyMatrix(&matrix);
+    freeCsrrgHeader(&header);
+    return sectionEdges < 0 ? (int)sectionEdges : 0;
+}
+
+/* One conversion of `input` the way processCsrrgFile does it; returns the time taken or -1. */
+static double run_pipelined(FILE *input, FILE *output) {
+    rewind(input);
+    rewind(output);
+
+    double t0 = now_seconds();
+    CsrrgHeader header;
+    if (readCsrrgHeader(input, &header) != 0) return -1.0;
+    CsrrgPipeline *pipeline = startCsrrgPipeline(input, CSRRG_PIPELINE_WORKERS, -1, NULL, CSRRG_EDGES_TEXT, NULL);
+    if (!pipeline) {
+        freeCsrrgHeader(&header);
+        return -1.0;
+    }
+    AdjacencyMatrix matrix = {NULL, 0, 0};
+    if (buildCsrrgRowCounts(&header) != 0 || fillCsrrgMatrix(&header, &matrix) != 0) {
+        cancelCsrrgPipeline(pipeline);
+        freeCsrrgHeader(&header);
+        return -1.0;
+    }
+    long edges = finishCsrrgPipeline(pipeline, output, &matrix, header.columns);
+    fflush(output);
+    double elapsed = now_seconds() - t0;
+
+    freeAdjacencyMatrix(&matrix);
+    freeCsrrgHeader(&header);
+    return edges < 0 ? -1.0 : elapsed;
+}
+
+static int bench_input(FILE *input, const char *name, int repeat, BenchResult *result) {
+    memset(result, 0, sizeof(*result));
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    fseek(input, 0, SEEK_END);
+    result->inputBytes = ftell(input);
+
+    FILE *output = tmpfile();
+    if (!output) {
+        fprintf(stderr, "Error creating temporary output file\n");
+        return -3;
+    }
+    for (int s = 0; s < BENCH_STAGES; s++) result->stages[s] = -1.0;
+
+    int status = 0;
+    for (int r = 0; r < repeat && status == 0; r++) {
+        double times[BENCH_STAGES];
+        status = run_once(input, output, result, times);
+        for (int s = 0; s < BENCH_STAGES && status == 0; s++) {
+            if (result->stages[s] < 0 || times[s] < result->stages[s]) result->stages[s] = times[s];
+        }
+        double pipelined = status == 0 ? run_pipelined(input, output) : -1.0;
+        if (pipelined >= 0 && (result->pipelined <= 0 || pipelined < result->pipelined)) {
+            result->pipelined = pipelined;
+        }
+    }
+    fclose(output);
+    if (status != 0) {
+        fprintf(stderr, "Conversion of %s failed with code %d\n", name, status);
+        return status;
+    }
+
+    result->total = 0;
+    for (int s = 0; s < BENCH_STAGES; s++) result->total += result->stages[s];
+    result->peakRssKb = -1;
+    return 0;
+}
+
+/* Benchmarks one input in a child process, so that its peak RSS is the
+   child's own rather than the high-water mark of every input so far. Where
+   fork is unavailable the input runs here and peakRssKb stays -1. */
+static int bench_file(FILE *input, const char *name, int repeat, BenchResult *result) {
+#ifndef _WIN32
+    int fds[2] = {-1, -1};
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = pipe(fds) == 0 ? fork() : -1;
+    if (pid == 0) {
+        close(fds[0]);
+        int status = bench_input(input, name, repeat, result);
+        ssize_t written = status == 0 ? write(fds[1], result, sizeof(*result)) : -1;
+        fflush(stderr);
+        _exit(written == (ssize_t)sizeof(*result) ? 0 : 1);
+    }
+    if (pid > 0) {
+        close(fds[1]);
+        size_t got = 0;
+        ssize_t n;
+        while (got < sizeof(*result) && (n = read(fds[0], (char *)result + got, sizeof(*result) - got)) > 0) {
+            got += n;
+        }
+        close(fds[0]);
+        int exitStatus;
+        struct rusage usage;
+        if (wait4(pid, &exitStatus, 0, &usage) != pid || !WIFEXITED(exitStatus) ||
+            WEXITSTATUS(exitStatus) != 0 || got != sizeof(*result)) {
+            return -1;
+        }
+        result->peakRssKb = usage.ru_maxrss;  // Kilobytes on Linux
+        return 0;
+    }
+    if (fds[0] >= 0) {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    fprintf(stderr, "Cannot fork for %s, peak RSS not measured\n", name);
+#endif
+    return bench_input(input, name, repeat, result);
+}
+
+/* A rows x rows grid with BENCH_SYNTHETIC_DEGREE random indices per row,
+   written to a temporary file in .csrrg form. */
+static FILE *make_synthetic(int rows) {
+    long m = (long)rows * BENCH_SYNTHETIC_DEGREE;
+    int *src = malloc(m * sizeof(int));
+    int *dst = malloc(m * sizeof(int));
+    FILE *f = tmpfile();
+    if (!src || !dst || !f) {
+        fprintf(stderr, "Error preparing synthetic input with %d rows\n", rows);
+        free(src);
+        free(dst);
+        if (f) fclose(f);
+        return NULL;
+    }
+    GraphRng rng;
+    graph_rng_seed(&rng, (uint64_t)rows);
+    for (long e = 0; e < m; e++) {
+        src[e] = (int)(e / BENCH_SYNTHETIC_DEGREE);
+        dst[e] = (int)(graph_rng_next(&rng) % rows);
+    }
+    SparseGraph graph;
+    int status = buildSparseGraph(rows, src, dst, (int)m, &graph);
+    free(src);
+    free(dst);
+    if (status != 0 || writeSparseCsrrgFile(f, &graph) != 0) {
+        fprintf(stderr, "Error writing synthetic input with %d rows\n", rows);
+        if (status == 0) freeSparseGraph(&graph);
+        fclose(f);
+        return NULL;
+    }
+    freeSparseGraph(&graph);
+    fflush(f);
+    return f;
+}
+
+static void print_json(FILE *out, const BenchResult *results, int count, int repeat) {
+    fprintf(out, "{\n  \"benchmark\": \"csrrg\",\n  \"repeat\": %d,\n  \"inputs\": [\n", repeat);
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        long edges = r->matrixEdges + r->sectionEdges;
+        fprintf(out, "    {\"name\": \"%s\", \"bytes\": %ld, \"output_bytes\": %ld, "
+                     "\"rows\": %d, \"columns\": %d, \"edges\": %ld,\n",
+                r->name, r->inputBytes, r->outputBytes, r->rows, r->columns, edges);
+        fprintf(out, "     \"stages\": {");
+        for (int s = 0; s < BENCH_STAGES; s++) {
+            fprintf(out, "%s\"%s\": %.9f", s ? ", " : "", stageNames[s], r->stages[s]);
+        }
+        fprintf(out, "},\n");
+        fprintf(out, "     \"total_s\": %.9f, \"mb_per_s\": %.3f, \"output_mb_per_s\": %.3f, "
+                     "\"edges_per_s\": %.1f, \"pipelined_s\": %.9f, \"peak_rss_kb\": %ld}%s\n",
+                r->total,
+                r->total > 0 ? r->inputBytes / 1e6 / r->total : 0.0,
+                r->total > 0 ? r->outputBytes / 1e6 / r->total : 0.0,
+                r->total > 0 ? edges / r->total : 0.0,
+                r->pipelined, r->peakRssKb, i < count - 1 ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+/* Reads "total_s" for the named input from a JSON file this program wrote. */
+static double baseline_total(const char *json, const char *name) {
+    char pattern[300];
+    snprintf(pattern, sizeof(pattern), "\"name\": \"%s\",", name);
+    const char *entry = strstr(json, pattern);
+    if (!entry) return -1.0;
+    const char *total = strstr(entry, "\"total_s\": ");
+    return total ? atof(total + strlen("\"total_s\": ")) : -1.0;
+}
+
+/* Prints the change of every input against the baseline; returns the
+   number of inputs that got slower by more than threshold percent. */
+static int compare_baseline(const char *fileName, const BenchResult *results, int count, double threshold) {
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        fprintf(stderr, "Error opening baseline %s\n", fileName);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *json = malloc(size + 1);
+    if (!json || fread(json, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "Error reading baseline %s\n", fileName);
+        free(json);
+        fclose(f);
+        return -1;
+    }
+    json[size] = '\0';
+    fclose(f);
+
+    int regressions = 0;
+    for (int i = 0; i < count; i++) {
+        double old = baseline_total(json, results[i].name);
+        if (old <= 0) {
+            fprintf(stderr, "%-24s no baseline\n", results[i].name);
+            continue;
+        }
+        double change = (results[i].total - old) / old * 100.0;
+        int regressed = change > threshold;
+        regressions += regressed;
+        fprintf(stderr, "%-24s %10.6f s -> %10.6f s  %+7.1f%%%s\n",
+                results[i].name, old, results[i].total, change, regressed ? "  REGRESSION" : "");
+    }
+    free(json);
+    return regressions;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [--repeat n] [--scale rows[,rows...]] [--out file.json]\n"
+        "          [--baseline old.json [--threshold pct]] [file.csrrg ...]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int repeat = 5;
+    int scales[BENCH_MAX_SCALES] = {1000, 4000};
+    int scaleCount = 2;
+    const char *outName = NULL;
+    const char *baseline = NULL;
+    double threshold = 10.0;
+    const char **inputs = malloc(argc * sizeof(char *));
+    int inputCount = 0;
+    if (!inputs) {
+        fprintf(stderr, "Memory allocation error\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        int hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && hasValue) {
+            scaleCount = 0;
+            char *saveptr;
+            for (char *tok = strtok_r(argv[++i], ",", &saveptr); tok && scaleCount < BENCH_MAX_SCALES;
+                 tok = strtok_r(NULL, ",", &saveptr)) {
+                if (atoi(tok) > 0) scales[scaleCount++] = atoi(tok);
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            outName = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            threshold = atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            free(inputs);
+            return 1;
+        } else {
+            inputs[inputCount++] = argv[i];
+        }
+    }
+    if (repeat <= 0) {
+        usage(argv[0]);
+        free(inputs);
+        return 1;
+    }
+    int useDefaults = inputCount == 0;
+    if (useDefaults) inputCount = sizeof(defaultInputs) / sizeof(defaultInputs[0]);
+
+    BenchResult *results = calloc(inputCount + scaleCount, sizeof(BenchResult));
+    if (!results) {
+        fprintf(stderr, "Memory allocation error\n");
+        free(inputs);
+        return 1;
+    }
+
+    int count = 0;
+    int failures = 0;
+    for (int i = 0; i < inputCount; i++) {
+        const char *name = useDefaults ? defaultInputs[i] : inputs[i];
+        FILE *f = fopen(name, "rb");
+        if (!f) {
+            fprintf(stderr, "Error opening file %s\n", name);
+            failures++;
+            continue;
+        }
+        if (bench_file(f, name, repeat, &results[count]) == 0) count++;
+        else failures++;
+        fclose(f);
+    }
+    for (int i = 0; i < scaleCount; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "synthetic-%d", scales[i]);
+        FILE *f = make_synthetic(scales[i]);
+        if (!f) {
+            failures++;
+            continue;
+        }
+        if (bench_file(f, name, repeat, &results[count]) == 0) count++;
+        else failures++;
+        fclose(f);
+    }
+
+    FILE *out = outName ? fopen(outName, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Error opening output file %s\n", outName);
+        out = stdout;
+    }
+    print_json(out, results, count, repeat);
+    if (out != stdout) fclose(out);
+
+    int regressions = 0;
+    if (baseline) {
+        regressions = compare_baseline(baseline, results, count, threshold);
+    }
+
+    free(results);
+    free(inputs);
+    return failures > 0 || regressions != 0 ? 2 : 0;
+}
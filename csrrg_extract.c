@@ -0,0 +1,463 @@
+#include "csrrg_extract.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csrrg.h"
+#include "csrrg_output.h"
+#include "csrrg_pipeline.h"
+#include "sparse_graph.h"
+#include "stats.h"
+#include "utils.h"
+
+#define EXTRACT_BUFFER_SIZE (1 << 16)
+
+// What is kept of the input graph
+typedef struct Extraction {
+    int *selected;      // Kept vertex ids, ascending; the new id is the position
+    int count;
+    int *relabel;       // vertexTotal entries, -1 for vertices not kept
+    int vertexTotal;
+    SparseGraph grid;   // Output rows; colIdx holds the line 2 value of every kept vertex
+    int columns;        // Highest kept column + 1
+} Extraction;
+
+static void free_extraction(Extraction *extraction) {
+    free(extraction->selected);
+    free(extraction->relabel);
+    freeSparseGraph(&extraction->grid);
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* The header lines are walked without tokenizing them: tokens are what
+   strtok(";") would return, so ids match the converter's. */
+static const char *first_token(const char *line) {
+    while (*line == ';') line++;
+    return line;
+}
+
+static const char *next_token(const char *p) {
+    const char *end = strchr(p, ';');
+    if (!end) return p + strlen(p);
+    while (*end == ';') end++;
+    return end;
+}
+
+static void trim_line(char *line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ')) {
+        line[--length] = '\0';
+    }
+}
+
+// Line 3 as an array; the pointers must never decrease
+static int parse_row_pointers(const char *line3, int **pointers, int *count) {
+    int capacity = 64;
+    *pointers = malloc(capacity * sizeof(int));
+    *count = 0;
+    if (!*pointers) {
+        fprintf(stderr, "Memory allocation error for row pointers\n");
+        return -2;
+    }
+    for (const char *p = first_token(line3); *p; p = next_token(p)) {
+        if (*count == capacity) {
+            capacity *= 2;
+            int *temp = realloc(*pointers, capacity * sizeof(int));
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error for row pointers\n");
+                return -5;
+            }
+            *pointers = temp;
+        }
+        int value = atoi(p);
+        if (*count > 0 && value < (*pointers)[*count - 1]) {
+            fprintf(stderr, "Header line 3: pointer %d (%d) is smaller than the one before\n", *count, value);
+            return -1;
+        }
+        (*pointers)[(*count)++] = value;
+    }
+    STATS_ADD(STATS_TOKENS_PARSED, *count);
+    if (*count < 2) {
+        fprintf(stderr, "Header line 3: no rows\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Row whose vertex range holds vertex, or -1
+static int row_of(const int *pointers, int count, int vertex) {
+    int low = 0, high = count - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (pointers[mid + 1] <= vertex) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < count - 1 && pointers[low] <= vertex && vertex < pointers[low + 1] ? low : -1;
+}
+
+/* Fills the relabel map, the output rows firstRow.. and the line 2 value of
+   every kept vertex. Line 2 is skipped token by token up to each kept
+   vertex; only the kept tokens are converted. */
+static int build_extraction(const CsrrgHeader *header, const int *pointers, int firstRow, int rows,
+                            Extraction *extraction) {
+    extraction->relabel = malloc(((size_t)extraction->vertexTotal + 1) * sizeof(int));
+    extraction->grid.n = rows;
+    extraction->grid.m = extraction->count;
+    extraction->grid.rowPtr = calloc((size_t)rows + 1, sizeof(int));
+    extraction->grid.colIdx = malloc(((size_t)extraction->count + 1) * sizeof(int));
+    if (!extraction->relabel || !extraction->grid.rowPtr || !extraction->grid.colIdx) {
+        fprintf(stderr, "Memory allocation error for extraction\n");
+        return -2;
+    }
+    memset(extraction->relabel, 0xff, ((size_t)extraction->vertexTotal + 1) * sizeof(int));
+
+    const char *p = first_token(header->line2);
+    int position = 0;
+    int row = firstRow;
+    extraction->columns = 0;
+    for (int i = 0; i < extraction->count; i++) {
+        int vertex = extraction->selected[i];
+        extraction->relabel[vertex] = i;
+        while (pointers[row + 1] <= vertex) {
+            extraction->grid.rowPtr[row - firstRow + 1] = i;
+            row++;
+        }
+        for (; position < vertex && *p; position++) p = next_token(p);
+        if (!*p) {
+            fprintf(stderr, "Header line 2 has fewer than %d indices\n", vertex + 1);
+            return -1;
+        }
+        int column = atoi(p);
+        extraction->grid.colIdx[i] = column;
+        if (column + 1 > extraction->columns) extraction->columns = column + 1;
+        p = next_token(p);
+        position++;
+    }
+    for (; row < firstRow + rows; row++) extraction->grid.rowPtr[row - firstRow + 1] = extraction->count;
+    STATS_ADD(STATS_TOKENS_PARSED, extraction->count);
+    return 0;
+}
+
+// Buffered "v;v;v\n" line of a .csrrg header
+static void write_token_line(CsrrgWriter *writer, char *buffer, const int *values, int count) {
+    size_t length = 0;
+    for (int i = 0; i < count; i++) {
+        if (length + 16 > EXTRACT_BUFFER_SIZE) {
+            csrrgWrite(writer, buffer, length);
+            length = 0;
+        }
+        if (i > 0) buffer[length++] = ';';
+        length = formatInt(buffer + length, values[i]) - buffer;
+    }
+    // Blank lines are skipped by the reader, so an empty line still needs a separator
+    if (count == 0) buffer[length++] = ';';
+    buffer[length++] = '\n';
+    csrrgWrite(writer, buffer, length);
+}
+
+static long write_csrrg_extract(const CsrrgHeader *header, const Extraction *extraction,
+                                CsrrgPipeline *pipeline, const char *output) {
+    FILE *file = fopen(output, "wb");
+    char *buffer = malloc(EXTRACT_BUFFER_SIZE);
+    if (!file || !buffer) {
+        if (file) {
+            fprintf(stderr, "Memory allocation error for output buffer\n");
+            fclose(file);
+        } else {
+            fprintf(stderr, "Error opening output file %s\n", output);
+        }
+        free(buffer);
+        cancelCsrrgPipeline(pipeline);
+        return file ? -2 : -3;
+    }
+    CsrrgWriter writer = {.file = file, .path = NULL};
+    int length = snprintf(buffer, EXTRACT_BUFFER_SIZE, "%d\n", header->maxRowNodes);
+    csrrgWrite(&writer, buffer, length);
+    write_token_line(&writer, buffer, extraction->grid.colIdx, extraction->grid.m);
+    write_token_line(&writer, buffer, extraction->grid.rowPtr, extraction->grid.n + 1);
+    free(buffer);
+    long edges = drainCsrrgPipeline(pipeline, &writer);
+    if (fclose(file) != 0 || writer.failed) {
+        fprintf(stderr, "Error writing %s\n", output);
+        return -3;
+    }
+    return edges;
+}
+
+// graf.bin layout: the rows' ones sorted and unique, as buildCsrrgGrid has them
+static long write_binary_extract(const Extraction *extraction, CsrrgPipeline *pipeline, const char *output) {
+    const SparseGraph *rows = &extraction->grid;
+    SparseGraph grid = {rows->n, 0, malloc(((size_t)rows->n + 1) * sizeof(int)),
+                        malloc(((size_t)rows->m + 1) * sizeof(int))};
+    if (!grid.rowPtr || !grid.colIdx) {
+        fprintf(stderr, "Memory allocation error for grid\n");
+        freeSparseGraph(&grid);
+        cancelCsrrgPipeline(pipeline);
+        return -2;
+    }
+    grid.rowPtr[0] = 0;
+    for (int i = 0; i < rows->n; i++) {
+        int start = grid.m;
+        for (int k = rows->rowPtr[i]; k < rows->rowPtr[i + 1]; k++) {
+            if (rows->colIdx[k] >= 0) grid.colIdx[grid.m++] = rows->colIdx[k];
+        }
+        qsort(grid.colIdx + start, grid.m - start, sizeof(int), compare_ints);
+        int unique = start;
+        for (int k = start; k < grid.m; k++) {
+            if (k == start || grid.colIdx[k] != grid.colIdx[unique - 1]) grid.colIdx[unique++] = grid.colIdx[k];
+        }
+        grid.m = unique;
+        grid.rowPtr[i + 1] = unique;
+    }
+
+    CsrrgOutput out;
+    int status = openCsrrgOutput(&out, CSRRG_OUT_BINARY, output);
+    if (status == 0) {
+        status = writeCsrrgGrid(&out, &grid, extraction->columns, extraction->count);
+        if (status != 0) closeCsrrgOutput(&out, -1);
+    }
+    freeSparseGraph(&grid);
+    if (status != 0) {
+        cancelCsrrgPipeline(pipeline);
+        return status;
+    }
+    long edges = drainCsrrgPipeline(pipeline, csrrgEdgeWriter(&out));
+    status = closeCsrrgOutput(&out, edges >= 0 ? edges : -1);
+    return edges < 0 ? edges : status < 0 ? status : edges;
+}
+
+static int has_suffix(const char *text, const char *suffix) {
+    size_t length = strlen(text), suffixLength = strlen(suffix);
+    return length >= suffixLength && strcmp(text + length - suffixLength, suffix) == 0;
+}
+
+/* Shared by both entry points: select() fills extraction->selected from
+   the row pointers and returns the first output row and the row count. */
+typedef int (*SelectVertices)(const int *pointers, int pointerCount, const void *request,
+                              Extraction *extraction, int *firstRow, int *rows);
+
+static int run_extraction(const char *input, SelectVertices select, const void *request, const char *output) {
+    FILE *f = fopen(input, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", input);
+        return -4;
+    }
+    CsrrgHeader header;
+    int status = readCsrrgHeader(f, &header);
+    if (status != 0) {
+        fclose(f);
+        return status;
+    }
+    trim_line(header.line2);
+    trim_line(header.line3);
+
+    Extraction extraction;
+    memset(&extraction, 0, sizeof(extraction));
+    int *pointers = NULL;
+    int pointerCount = 0, firstRow = 0, rows = 0;
+    status = parse_row_pointers(header.line3, &pointers, &pointerCount);
+    if (status == 0) {
+        extraction.vertexTotal = pointers[pointerCount - 1];
+        status = select(pointers, pointerCount, request, &extraction, &firstRow, &rows);
+    }
+    if (status == 0) status = build_extraction(&header, pointers, firstRow, rows, &extraction);
+    free(pointers);
+
+    long edges = status;
+    if (status == 0) {
+        // The workers check every section against vertexTotal, which keeps lookups inside the map
+        int binary = has_suffix(output, ".bin");
+        CsrrgPipeline *pipeline = startCsrrgPipeline(f, CSRRG_PIPELINE_WORKERS, extraction.vertexTotal,
+                                                     extraction.relabel,
+                                                     binary ? CSRRG_EDGES_BINARY : CSRRG_EDGES_SECTION, NULL);
+        if (!pipeline) {
+            fprintf(stderr, "Could not start the extraction pipeline\n");
+            edges = -2;
+        } else if (binary) {
+            edges = write_binary_extract(&extraction, pipeline, output);
+        } else {
+            edges = write_csrrg_extract(&header, &extraction, pipeline, output);
+        }
+    }
+    if (edges >= 0) {
+        printf("Extracted %d vertices in %d rows, %ld edges to %s\n", extraction.count, rows, edges, output);
+    }
+    free_extraction(&extraction);
+    freeCsrrgHeader(&header);
+    fclose(f);
+    return edges < 0 ? (int)edges : 0;
+}
+
+typedef struct RowRange {
+    int first;
+    int last;
+} RowRange;
+
+static int select_rows(const int *pointers, int pointerCount, const void *request, Extraction *extraction,
+                       int *firstRow, int *rows) {
+    const RowRange *range = request;
+    if (range->first < 0 || range->first >= range->last || range->last > pointerCount - 1) {
+        fprintf(stderr, "Row range %d:%d outside the %d rows of the graph\n", range->first, range->last,
+                pointerCount - 1);
+        return -1;
+    }
+    *firstRow = range->first;
+    *rows = range->last - range->first;
+    int begin = pointers[range->first];
+    extraction->count = pointers[range->last] - begin;
+    extraction->selected = malloc(((size_t)extraction->count + 1) * sizeof(int));
+    if (!extraction->selected) {
+        fprintf(stderr, "Memory allocation error for extraction\n");
+        return -2;
+    }
+    for (int i = 0; i < extraction->count; i++) extraction->selected[i] = begin + i;
+    return 0;
+}
+
+int extractCsrrgRows(const char *input, int first, int last, const char *output) {
+    RowRange range = {first, last};
+    return run_extraction(input, select_rows, &range, output);
+}
+
+typedef struct VertexList {
+    const int *vertices;
+    int count;
+} VertexList;
+
+static int select_vertices(const int *pointers, int pointerCount, const void *request, Extraction *extraction,
+                           int *firstRow, int *rows) {
+    const VertexList *list = request;
+    if (list->count <= 0) {
+        fprintf(stderr, "No vertices to extract\n");
+        return -1;
+    }
+    extraction->selected = malloc((size_t)list->count * sizeof(int));
+    if (!extraction->selected) {
+        fprintf(stderr, "Memory allocation error for extraction\n");
+        return -2;
+    }
+    memcpy(extraction->selected, list->vertices, (size_t)list->count * sizeof(int));
+    qsort(extraction->selected, list->count, sizeof(int), compare_ints);
+    int unique = 0;
+    for (int i = 0; i < list->count; i++) {
+        if (i == 0 || extraction->selected[i] != extraction->selected[unique - 1]) {
+            extraction->selected[unique++] = extraction->selected[i];
+        }
+    }
+    extraction->count = unique;
+    int low = row_of(pointers, pointerCount, extraction->selected[0]);
+    int high = row_of(pointers, pointerCount, extraction->selected[unique - 1]);
+    if (low < 0 || high < 0) {
+        fprintf(stderr, "Vertex %d is in no row of the graph (vertices 0..%d)\n",
+                low < 0 ? extraction->selected[0] : extraction->selected[unique - 1], extraction->vertexTotal - 1);
+        return -1;
+    }
+    *firstRow = low;
+    *rows = high - low + 1;
+    return 0;
+}
+
+int extractCsrrgSubgraph(const char *input, const int *vertices, int count, const char *output) {
+    VertexList list = {vertices, count};
+    return run_extraction(input, select_vertices, &list, output);
+}
+
+static int append_vertex(int **vertices, int *count, int *capacity, long value) {
+    if (value < 0 || value > 0x7fffffff) {
+        fprintf(stderr, "Invalid vertex id %ld\n", value);
+        return -1;
+    }
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        int *temp = realloc(*vertices, *capacity * sizeof(int));
+        if (!temp) {
+            fprintf(stderr, "Memory allocation error for vertex list\n");
+            return -5;
+        }
+        *vertices = temp;
+    }
+    (*vertices)[(*count)++] = (int)value;
+    return 0;
+}
+
+/* "3,7,10-20" (ranges inclusive) or "@file" with ids separated by commas,
+   spaces or newlines. */
+static int parse_vertex_list(const char *spec, int **vertices, int *count) {
+    *vertices = NULL;
+    *count = 0;
+    int capacity = 0;
+    char *text = NULL;
+    if (spec[0] == '@') {
+        FILE *f = fopen(spec + 1, "r");
+        if (!f) {
+            fprintf(stderr, "Error opening file %s\n", spec + 1);
+            return -4;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        text = size >= 0 ? malloc(size + 1) : NULL;
+        if (text) text[fread(text, 1, size, f)] = '\0';
+        fclose(f);
+    } else {
+        text = strdup(spec);
+    }
+    if (!text) {
+        fprintf(stderr, "Memory allocation error for vertex list\n");
+        return -2;
+    }
+    int status = 0;
+    char *saveptr;
+    for (char *item = strtok_r(text, ", \t\r\n", &saveptr); item && status == 0;
+         item = strtok_r(NULL, ", \t\r\n", &saveptr)) {
+        char *end;
+        long first = strtol(item, &end, 10), last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (*end != '\0' || end == item || last < first) {
+            fprintf(stderr, "Invalid vertex list item: %s\n", item);
+            status = -1;
+        }
+        for (long v = first; v <= last && status == 0; v++) status = append_vertex(vertices, count, &capacity, v);
+    }
+    free(text);
+    if (status != 0) {
+        free(*vertices);
+        *vertices = NULL;
+    }
+    return status;
+}
+
+int extractCsrrgFile(int argc, char **argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Usage: --extract file.csrrg rows=A:B|vertices=LIST out.csrrg|out.bin\n");
+        return -1;
+    }
+    const char *spec = argv[3];
+    if (strncmp(spec, "rows=", 5) == 0) {
+        int first, last;
+        char extra;
+        if (sscanf(spec + 5, "%d:%d%c", &first, &last, &extra) != 2) {
+            fprintf(stderr, "Invalid row range %s, expected rows=A:B\n", spec + 5);
+            return -1;
+        }
+        return extractCsrrgRows(argv[2], first, last, argv[4]);
+    }
+    if (strncmp(spec, "vertices=", 9) == 0) {
+        int *vertices, count;
+        int status = parse_vertex_list(spec + 9, &vertices, &count);
+        if (status != 0) return status;
+        status = extractCsrrgSubgraph(argv[2], vertices, count, argv[4]);
+        free(vertices);
+        return status;
+    }
+    fprintf(stderr, "Expected rows=A:B or vertices=LIST, got %s\n", spec);
+    return -1;
+}
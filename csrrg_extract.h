@@ -0,0 +1,19 @@
+#ifndef CSRRG_EXTRACT_H
+#define CSRRG_EXTRACT_H
+
+/* Part of a .csrrg graph as a graph of its own. The rows and vertices come
+   from the header alone: line 3 gives the vertex range of every row, and
+   line 2 is only converted for the vertices kept. Kept vertices are
+   numbered 0, 1, ... in their original order; the edge sections are
+   filtered and relabelled by the pipeline workers. The output is a .csrrg
+   file, or the graf.bin layout when the path ends in ".bin". */
+
+// Rows [first, last) and the edges between their vertices
+int extractCsrrgRows(const char *input, int first, int last, const char *output);
+// The subgraph induced by `count` vertex ids, in any order, duplicates allowed
+int extractCsrrgSubgraph(const char *input, const int *vertices, int count, const char *output);
+
+// graph_gen --extract file.csrrg rows=A:B|vertices=LIST out.csrrg|out.bin
+int extractCsrrgFile(int argc, char **argv);
+
+#endif // CSRRG_EXTRACT_H
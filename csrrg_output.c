@@ -0,0 +1,312 @@
+#include "csrrg_output.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "stats.h"
+#include "utils.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+#define MTX_BANNER "%%MatrixMarket matrix coordinate pattern general\n"
+#define BINARY_MAGIC "CSRRGBN1"
+
+CsrrgOutputFormat csrrgOutputFormat = CSRRG_OUT_DENSE;
+
+static const struct {
+    const char *name;
+    CsrrgOutputFormat format;
+    const char *fileName;
+} outputFormats[] = {
+    {"dense", CSRRG_OUT_DENSE, "graf.txt"},
+    {"edges", CSRRG_OUT_EDGES, "graf.edges"},
+    {"mtx", CSRRG_OUT_MTX, "graf.mtx"},
+    {"bin", CSRRG_OUT_BINARY, "graf.bin"},
+    {"gz", CSRRG_OUT_DENSE_GZ, "graf.txt.gz"},
+};
+
+int parseCsrrgOutputFormat(const char *name, CsrrgOutputFormat *format) {
+    for (size_t i = 0; i < sizeof(outputFormats) / sizeof(outputFormats[0]); i++) {
+        if (strcmp(name, outputFormats[i].name) == 0) {
+#ifndef HAVE_ZLIB
+            if (outputFormats[i].format == CSRRG_OUT_DENSE_GZ) {
+                fprintf(stderr, "Output format gz needs zlib, which this build does not have\n");
+                return -1;
+            }
+#endif
+            *format = outputFormats[i].format;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Unknown output format: %s (use dense, edges, mtx, bin or gz)\n", name);
+    return -1;
+}
+
+CsrrgEdgeStyle csrrgEdgeStyle(CsrrgOutputFormat format) {
+    if (format == CSRRG_OUT_MTX) return CSRRG_EDGES_MTX;
+    if (format == CSRRG_OUT_BINARY) return CSRRG_EDGES_BINARY;
+    return CSRRG_EDGES_TEXT;
+}
+
+size_t csrrgWrite(CsrrgWriter *writer, const void *data, size_t length) {
+    if (length == 0) return 0;
+#ifdef HAVE_ZLIB
+    if (writer->gz) {
+        int written = gzwrite((gzFile)writer->gz, data, (unsigned)length);
+        if (written <= 0) {
+            writer->failed = 1;
+            return 0;
+        }
+        return (size_t)written;
+    }
+#endif
+    size_t written = fwrite(data, 1, length, writer->file);
+    if (written < length) writer->failed = 1;
+    return written;
+}
+
+static const char *output_file_name(CsrrgOutputFormat format) {
+    for (size_t i = 0; i < sizeof(outputFormats) / sizeof(outputFormats[0]); i++) {
+        if (outputFormats[i].format == format) return outputFormats[i].fileName;
+    }
+    return "graf.txt";
+}
+
+// Opens name + ".tmp" for writing; close_writer gives it its own name
+static int open_writer(CsrrgWriter *writer, const char *name, int gzip) {
+    size_t length = strlen(name);
+    writer->path = malloc(length + 5);
+    if (!writer->path) {
+        fprintf(stderr, "Memory allocation error for output file name\n");
+        return -2;
+    }
+    memcpy(writer->path, name, length);
+    memcpy(writer->path + length, ".tmp", 5);
+#ifdef HAVE_ZLIB
+    if (gzip) {
+        // Fastest level: the runs of "0. " compress well anyway
+        writer->gz = gzopen(writer->path, "wb1");
+        if (writer->gz) gzbuffer((gzFile)writer->gz, 1 << 20);
+    }
+#else
+    (void)gzip;
+#endif
+    if (!gzip) writer->file = fopen(writer->path, "wb");
+    if (!writer->file && !writer->gz) {
+        fprintf(stderr, "Error opening output file %s\n", name);
+        free(writer->path);
+        writer->path = NULL;
+        return -3;
+    }
+    writer->path[length] = '\0';
+    return 0;
+}
+
+int openCsrrgOutput(CsrrgOutput *output, CsrrgOutputFormat format, const char *path) {
+    memset(output, 0, sizeof(*output));
+    output->format = format;
+    output->countOffset = -1;
+    const char *name = path ? path : output_file_name(format);
+    int status = open_writer(&output->main, name, format == CSRRG_OUT_DENSE_GZ);
+    if (status != 0) return status;
+    if (format == CSRRG_OUT_MTX) {
+        status = open_writer(&output->edgesFile, "graf_edges.mtx", 0);
+        if (status != 0) {
+            closeCsrrgOutput(output, -1);
+            return status;
+        }
+    }
+    return 0;
+}
+
+CsrrgWriter *csrrgEdgeWriter(CsrrgOutput *output) {
+    return output->edgesFile.file ? &output->edgesFile : &output->main;
+}
+
+// Small write buffer in front of a CsrrgWriter
+typedef struct OutputBuffer {
+    CsrrgWriter *writer;
+    char *data;
+    size_t length;
+    long written;
+} OutputBuffer;
+
+// Makes room for `needed` more bytes and returns where they go
+static char *reserve(OutputBuffer *buffer, size_t needed) {
+    if (buffer->length + needed > OUTPUT_BUFFER_SIZE) {
+        buffer->written += csrrgWrite(buffer->writer, buffer->data, buffer->length);
+        buffer->length = 0;
+    }
+    return buffer->data + buffer->length;
+}
+
+static void flush_buffer(OutputBuffer *buffer) {
+    buffer->written += csrrgWrite(buffer->writer, buffer->data, buffer->length);
+    buffer->length = 0;
+}
+
+/* Dense rows exactly as printAdjacencyMatrixToFile writes them, built
+   from a row of zeros with the ones patched in. */
+static int write_dense_rows(OutputBuffer *buffer, const SparseGraph *grid, int columns) {
+    size_t rowLength = columns > 0 ? (size_t)columns * 3 - 1 : 0;
+    char *row = malloc(rowLength + 4);
+    if (!row) {
+        fprintf(stderr, "Memory allocation error for dense row\n");
+        return -2;
+    }
+    memcpy(row, " [", 2);
+    for (int j = 0; j < columns; j++) {
+        memcpy(row + 2 + 3 * (size_t)j, j < columns - 1 ? "0. " : "0.", j < columns - 1 ? 3 : 2);
+    }
+    memcpy(row + 2 + rowLength, "]\n", 2);
+
+    for (int i = 0; i < grid->n; i++) {
+        for (int k = grid->rowPtr[i]; k < grid->rowPtr[i + 1]; k++) row[2 + 3 * (size_t)grid->colIdx[k]] = '1';
+        if (rowLength + 4 > OUTPUT_BUFFER_SIZE) {
+            flush_buffer(buffer);
+            buffer->written += csrrgWrite(buffer->writer, row, rowLength + 4);
+        } else {
+            memcpy(reserve(buffer, rowLength + 4), row, rowLength + 4);
+            buffer->length += rowLength + 4;
+        }
+        for (int k = grid->rowPtr[i]; k < grid->rowPtr[i + 1]; k++) row[2 + 3 * (size_t)grid->colIdx[k]] = '0';
+    }
+    free(row);
+    return 0;
+}
+
+// One line per one of the matrix: "row col", or 1-based for Matrix Market
+static void write_coordinates(OutputBuffer *buffer, const SparseGraph *grid, int base) {
+    for (int i = 0; i < grid->n; i++) {
+        for (int k = grid->rowPtr[i]; k < grid->rowPtr[i + 1]; k++) {
+            char *out = reserve(buffer, 48);
+            out = formatInt(out, (long long)i + base);
+            *out++ = ' ';
+            out = formatInt(out, (long long)grid->colIdx[k] + base);
+            *out++ = '\n';
+            buffer->length = out - buffer->data;
+        }
+    }
+}
+
+static void write_int32_array(OutputBuffer *buffer, const int *values, long count) {
+    for (long i = 0; i < count; i++) {
+        putInt32LE(reserve(buffer, 4), (uint32_t)values[i]);
+        buffer->length += 4;
+    }
+}
+
+/* Writes the matrix part of the output from the CSR grid and, where the
+   edge count goes in front of the edges, leaves room for it. The edge
+   sections follow through csrrgEdgeWriter. */
+int writeCsrrgGrid(CsrrgOutput *output, const SparseGraph *grid, int columns, int vertexTotal) {
+    OutputBuffer buffer = {&output->main, malloc(OUTPUT_BUFFER_SIZE), 0, 0};
+    if (!buffer.data) {
+        fprintf(stderr, "Memory allocation error for output buffer\n");
+        return -2;
+    }
+    int status = 0;
+    char header[160];
+    int length;
+    switch (output->format) {
+    case CSRRG_OUT_DENSE:
+    case CSRRG_OUT_DENSE_GZ:
+        status = write_dense_rows(&buffer, grid, columns);
+        break;
+    case CSRRG_OUT_EDGES:
+        write_coordinates(&buffer, grid, 0);
+        memcpy(reserve(&buffer, 1), "\n", 1);  // Blank line before the edges
+        buffer.length++;
+        break;
+    case CSRRG_OUT_MTX:
+        length = snprintf(header, sizeof(header), "%s%d %d %d\n", MTX_BANNER, grid->n, columns, grid->m);
+        memcpy(reserve(&buffer, length), header, length);
+        buffer.length += length;
+        write_coordinates(&buffer, grid, 1);
+        // graf_edges.mtx: vertexTotal x vertexTotal, entry count filled in on close
+        length = snprintf(header, sizeof(header), "%s%d %d ", MTX_BANNER, vertexTotal, vertexTotal);
+        csrrgWrite(&output->edgesFile, header, length);
+        output->countOffset = length;
+        csrrgWrite(&output->edgesFile, "                    \n", 21);
+        break;
+    case CSRRG_OUT_BINARY: {
+        memcpy(reserve(&buffer, 8), BINARY_MAGIC, 8);
+        buffer.length += 8;
+        int sizes[4] = {grid->n, columns, grid->m, vertexTotal};
+        write_int32_array(&buffer, sizes, 4);
+        write_int32_array(&buffer, grid->rowPtr, (long)grid->n + 1);
+        write_int32_array(&buffer, grid->colIdx, grid->m);
+        output->countOffset = 8 + 16 + ((long)grid->n + 1 + grid->m) * 4;
+        memset(reserve(&buffer, 8), 0, 8);  // int64 edge count, filled in on close
+        buffer.length += 8;
+        break;
+    }
+    }
+    flush_buffer(&buffer);
+    free(buffer.data);
+    STATS_ADD(STATS_BYTES_WRITTEN, buffer.written);
+    return status;
+}
+
+// Closes the file and renames it from its ".tmp" name, or removes it unless keep is set
+static int close_writer(CsrrgWriter *writer, int keep) {
+    int failed = writer->failed;
+#ifdef HAVE_ZLIB
+    if (writer->gz && gzclose((gzFile)writer->gz) != Z_OK) failed = 1;
+#endif
+    if (writer->file) {
+        if (ferror(writer->file)) failed = 1;
+        if (fclose(writer->file) != 0) failed = 1;
+    }
+    if (writer->path) {
+        size_t length = strlen(writer->path);
+        char *temporary = malloc(length + 5);
+        if (temporary) {
+            memcpy(temporary, writer->path, length);
+            memcpy(temporary + length, ".tmp", 5);
+            if (keep && !failed) {
+                if (rename(temporary, writer->path) != 0) failed = 1;
+            } else {
+                remove(temporary);
+            }
+            free(temporary);
+        } else {
+            failed = 1;
+        }
+        free(writer->path);
+    }
+    writer->gz = NULL;
+    writer->file = NULL;
+    writer->path = NULL;
+    return failed;
+}
+
+/* Fills in the edge count where the format needs it (edges >= 0) and
+   closes every file. Returns -3 if anything could not be written. */
+int closeCsrrgOutput(CsrrgOutput *output, long edges) {
+    if (edges >= 0 && output->countOffset >= 0) {
+        if (output->format == CSRRG_OUT_BINARY) {
+            char count[8];
+            putInt32LE(putInt32LE(count, (uint32_t)edges), (uint32_t)((unsigned long long)edges >> 32));
+            if (fseek(output->main.file, output->countOffset, SEEK_SET) != 0 ||
+                fwrite(count, 1, 8, output->main.file) != 8) {
+                output->main.failed = 1;
+            }
+        } else if (output->format == CSRRG_OUT_MTX) {
+            if (fseek(output->edgesFile.file, output->countOffset, SEEK_SET) != 0 ||
+                fprintf(output->edgesFile.file, "%20ld", edges) != 20) {
+                output->edgesFile.failed = 1;
+            }
+        }
+    }
+    int keep = edges >= 0 && !output->main.failed && !output->edgesFile.failed;
+    int failed = close_writer(&output->main, keep);
+    failed |= close_writer(&output->edgesFile, keep);
+    if (failed) {
+        fprintf(stderr, "Error writing converted output\n");
+        return -3;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef CSRRG_OUTPUT_H
+#define CSRRG_OUTPUT_H
+
+#include <stdio.h>
+#include "csrrg.h"
+#include "sparse_graph.h"
+
+// Output of processCsrrgFile, chosen with --format
+typedef enum CsrrgOutputFormat {
+    CSRRG_OUT_DENSE,     // graf.txt, " [0. 1. ...]" rows then "src - dest"
+    CSRRG_OUT_EDGES,     // graf.edges, "row col" per one, blank line, "src - dest"
+    CSRRG_OUT_MTX,       // graf.mtx (the matrix) and graf_edges.mtx (the edges), Matrix Market
+    CSRRG_OUT_BINARY,    // graf.bin, little-endian CSR dump followed by the edges
+    CSRRG_OUT_DENSE_GZ   // graf.txt.gz, graf.txt compressed with gzip
+} CsrrgOutputFormat;
+
+extern CsrrgOutputFormat csrrgOutputFormat;
+
+// Sink for converted output: a plain file or, for gzip, a zlib stream
+typedef struct CsrrgWriter {
+    FILE *file;
+    void *gz;     // gzFile, kept opaque so zlib.h stays out of the headers
+    int failed;
+    char *path;   // Final file name; until closed the data goes to path + ".tmp"
+} CsrrgWriter;
+
+size_t csrrgWrite(CsrrgWriter *writer, const void *data, size_t length);
+
+typedef struct CsrrgOutput {
+    CsrrgOutputFormat format;
+    CsrrgWriter main;       // The matrix, and the edges unless edgesFile is used
+    CsrrgWriter edgesFile;  // Second Matrix Market file
+    long countOffset;       // Where the edge count is filled in on close, or -1
+} CsrrgOutput;
+
+int parseCsrrgOutputFormat(const char *name, CsrrgOutputFormat *format);
+CsrrgEdgeStyle csrrgEdgeStyle(CsrrgOutputFormat format);
+// path NULL: the format's usual file name (graf.txt, graf.bin, ...)
+int openCsrrgOutput(CsrrgOutput *output, CsrrgOutputFormat format, const char *path);
+CsrrgWriter *csrrgEdgeWriter(CsrrgOutput *output);
+int writeCsrrgGrid(CsrrgOutput *output, const SparseGraph *grid, int columns, int vertexTotal);
+/* Files are written under a ".tmp" name and only renamed to their own on a
+   successful close (edges >= 0), so a failed conversion leaves no partial
+   output and keeps whatever an earlier run wrote. */
+int closeCsrrgOutput(CsrrgOutput *output, long edges);
+
+#endif // CSRRG_OUTPUT_H
@@ -0,0 +1,211 @@
+#include "csrrg_pipeline.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "csrrg.h"
+#include "csrrg_validate.h"
+#include "spsc_queue.h"
+#include "stats.h"
+
+#define PIPELINE_QUEUE_SECTIONS 4  // Sections buffered between two stages, per worker
+
+typedef struct PipelineWorker {
+    SpscQueue in;   // Raw sections from the reader
+    SpscQueue out;  // Formatted sections for the writer
+    pthread_t thread;
+    int vertexLimit;  // -1 when not validating
+    CsrrgStatsAccumulator stats;
+    int collectStats;
+} PipelineWorker;
+
+struct CsrrgPipeline {
+    FILE *input;
+    int vertexLimit;
+    CsrrgEdgeStyle style;
+    const int *relabel;
+    CsrrgGraphStats *stats;
+    PipelineWorker *workers;
+    int workerCount;
+    pthread_t reader;
+    int readStatus;         // Set by the reader before it closes the queues
+    _Atomic int cancelled;
+};
+
+/* Reader stage: section k goes to worker k % workerCount, which is the
+   order the writer collects them in. */
+static void *pipeline_reader(void *arg) {
+    CsrrgPipeline *pipeline = arg;
+    char *line = NULL;
+    size_t capacity = 0;
+    int status = 0;
+    for (long k = 0; !atomic_load_explicit(&pipeline->cancelled, memory_order_relaxed); k++) {
+        CsrrgSection *section = calloc(1, sizeof(CsrrgSection));
+        if (!section) {
+            fprintf(stderr, "Memory allocation error for edge section\n");
+            status = -2;
+            break;
+        }
+        status = readCsrrgEdgeSection(pipeline->input, &line, &capacity, section);
+        if (status <= 0) {
+            free(section);
+            if (status == -1 && pipeline->vertexLimit < 0) status = 0;  // Incomplete last section is ignored
+            break;
+        }
+        section->index = (int)k + 1;
+        section->style = pipeline->style;
+        section->relabel = pipeline->relabel;
+        spscPush(&pipeline->workers[k % pipeline->workerCount].in, section);
+        status = 0;
+    }
+    free(line);
+    pipeline->readStatus = status < 0 ? status : 0;
+    for (int i = 0; i < pipeline->workerCount; i++) {
+        closeSpscQueue(&pipeline->workers[i].in);
+    }
+    return NULL;
+}
+
+// Parse stage
+static void *pipeline_worker(void *arg) {
+    PipelineWorker *worker = arg;
+    CsrrgSection *section;
+    while ((section = spscPop(&worker->in)) != NULL) {
+        section->status = 0;
+        if (worker->vertexLimit >= 0) {
+            CsrrgSectionInfo info;
+            section->status = validateCsrrgSection(section, section->index, worker->vertexLimit, &info);
+        }
+        section->stats = worker->collectStats ? &worker->stats : NULL;
+        if (section->status == 0) section->status = formatCsrrgEdgeSection(section);
+        free(section->edgeLine);
+        free(section->pointerLine);
+        section->edgeLine = section->pointerLine = NULL;
+        spscPush(&worker->out, section);
+    }
+    closeSpscQueue(&worker->out);
+    return NULL;
+}
+
+static void free_pipeline(CsrrgPipeline *pipeline) {
+    for (int i = 0; i < pipeline->workerCount; i++) {
+        freeSpscQueue(&pipeline->workers[i].in);
+        freeSpscQueue(&pipeline->workers[i].out);
+        freeCsrrgStatsAccumulator(&pipeline->workers[i].stats);
+    }
+    free(pipeline->workers);
+    free(pipeline);
+}
+
+/* Returns NULL if the queues or threads cannot be set up; the caller can
+   then fall back to printCsrrgEdgeSections, nothing has been read yet. */
+CsrrgPipeline *startCsrrgPipeline(FILE *input, int workers, int vertexLimit, const int *relabel,
+                                  CsrrgEdgeStyle style, CsrrgGraphStats *stats) {
+    if (workers < 1) workers = 1;
+    CsrrgPipeline *pipeline = calloc(1, sizeof(CsrrgPipeline));
+    if (!pipeline) {
+        fprintf(stderr, "Memory allocation error for pipeline\n");
+        return NULL;
+    }
+    pipeline->input = input;
+    pipeline->vertexLimit = vertexLimit;
+    pipeline->style = style;
+    pipeline->relabel = relabel;
+    pipeline->stats = stats;
+    atomic_init(&pipeline->cancelled, 0);
+    pipeline->workers = calloc(workers, sizeof(PipelineWorker));
+    if (!pipeline->workers) {
+        fprintf(stderr, "Memory allocation error for pipeline\n");
+        free(pipeline);
+        return NULL;
+    }
+    for (; pipeline->workerCount < workers; pipeline->workerCount++) {
+        PipelineWorker *worker = &pipeline->workers[pipeline->workerCount];
+        worker->vertexLimit = vertexLimit;
+        worker->collectStats = stats != NULL;
+        if (stats) worker->stats.limit = stats->total.limit;
+        if (initSpscQueue(&worker->in, PIPELINE_QUEUE_SECTIONS) != 0) break;
+        if (initSpscQueue(&worker->out, PIPELINE_QUEUE_SECTIONS) != 0) {
+            freeSpscQueue(&worker->in);
+            break;
+        }
+    }
+    if (pipeline->workerCount < workers) {
+        free_pipeline(pipeline);
+        return NULL;
+    }
+
+    int started = 0;
+    for (; started < workers; started++) {
+        PipelineWorker *worker = &pipeline->workers[started];
+        if (pthread_create(&worker->thread, NULL, pipeline_worker, worker) != 0) break;
+    }
+    if (started < workers || pthread_create(&pipeline->reader, NULL, pipeline_reader, pipeline) != 0) {
+        fprintf(stderr, "Error starting pipeline threads\n");
+        for (int i = 0; i < started; i++) {
+            closeSpscQueue(&pipeline->workers[i].in);
+            pthread_join(pipeline->workers[i].thread, NULL);
+        }
+        free_pipeline(pipeline);
+        return NULL;
+    }
+    return pipeline;
+}
+
+/* Writer stage for graf.txt: the dense matrix, then the sections. */
+long finishCsrrgPipeline(CsrrgPipeline *pipeline, FILE *result, const AdjacencyMatrix *matrix, int columns) {
+    // The workers keep parsing sections while this is written
+    uint64_t phase = statsPhaseBegin();
+    printAdjacencyMatrixToFile(result, matrix, columns);
+    statsPhaseEnd(STATS_DENSE_PRINT, phase);
+
+    CsrrgWriter out = {.file = result, .path = NULL};
+    return drainCsrrgPipeline(pipeline, &out);
+}
+
+/* Writes the sections in input order. With out == NULL everything is
+   drained and dropped. */
+long drainCsrrgPipeline(CsrrgPipeline *pipeline, CsrrgWriter *out) {
+    uint64_t phase = statsPhaseBegin();
+    long edgesPrinted = 0;
+    long tokens = 0;
+    long written = 0;
+    int status = 0;
+    CsrrgSection *section;
+    for (long k = 0; (section = spscPop(&pipeline->workers[k % pipeline->workerCount].out)) != NULL; k++) {
+        tokens += section->tokens;
+        if (status == 0 && section->status != 0) {
+            status = section->status;
+            atomic_store_explicit(&pipeline->cancelled, 1, memory_order_relaxed);
+        }
+        if (status == 0 && out) {
+            written += csrrgWrite(out, section->text, section->length);
+            edgesPrinted += section->edges;
+        }
+        if (status == 0 && pipeline->stats) status = addCsrrgSectionSize(pipeline->stats, section);
+        freeCsrrgSection(section);
+        free(section);
+    }
+
+    pthread_join(pipeline->reader, NULL);
+    for (int i = 0; i < pipeline->workerCount; i++) {
+        pthread_join(pipeline->workers[i].thread, NULL);
+        if (status == 0 && pipeline->stats) {
+            status = mergeCsrrgStatsAccumulator(pipeline->stats, &pipeline->workers[i].stats);
+        }
+    }
+    if (status == 0) status = pipeline->readStatus;
+    free_pipeline(pipeline);
+    statsPhaseEnd(STATS_EDGE_SECTIONS, phase);
+
+    STATS_ADD(STATS_TOKENS_PARSED, tokens);
+    STATS_ADD(STATS_EDGES_EMITTED, edgesPrinted);
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    return status < 0 ? status : edgesPrinted;
+}
+
+void cancelCsrrgPipeline(CsrrgPipeline *pipeline) {
+    atomic_store_explicit(&pipeline->cancelled, 1, memory_order_relaxed);
+    drainCsrrgPipeline(pipeline, NULL);
+}
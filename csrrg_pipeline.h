@@ -0,0 +1,33 @@
+#ifndef CSRRG_PIPELINE_H
+#define CSRRG_PIPELINE_H
+
+#include <stdio.h>
+#include "csrrg_output.h"
+#include "csrrg_stats.h"
+#include "graph_matrix.h"
+
+#define CSRRG_PIPELINE_WORKERS 2  // Parse workers used by processCsrrgFile
+
+/* Conversion of the edge sections of a .csrrg file as a pipeline: a reader
+   thread reads sections ahead and deals them round-robin to parse workers,
+   the calling thread writes the dense matrix and then the formatted
+   sections in input order. All stages are linked by bounded SPSC queues. */
+typedef struct CsrrgPipeline CsrrgPipeline;
+
+/* Starts reading the sections that follow the header already read from
+   input; the workers format the edges in `style`. With vertexLimit >= 0
+   they also validate every section against that many vertices and an
+   incomplete last section is an error. A relabel map (see CsrrgSection)
+   needs vertexLimit set, so that every vertex is within the map. With
+   stats set, every worker counts the edges it parses in an accumulator of
+   its own; draining merges them into stats and records each section's size. */
+CsrrgPipeline *startCsrrgPipeline(FILE *input, int workers, int vertexLimit, const int *relabel,
+                                  CsrrgEdgeStyle style, CsrrgGraphStats *stats);
+// Writes the matrix and every section to result; returns the edge count or a negative code
+long finishCsrrgPipeline(CsrrgPipeline *pipeline, FILE *result, const AdjacencyMatrix *matrix, int columns);
+// Writes every section to out (NULL drops them); returns the edge count or a negative code
+long drainCsrrgPipeline(CsrrgPipeline *pipeline, CsrrgWriter *out);
+// Stops reading and discards whatever was already parsed
+void cancelCsrrgPipeline(CsrrgPipeline *pipeline);
+
+#endif // CSRRG_PIPELINE_H
@@ -0,0 +1,236 @@
+#include "csrrg_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int csrrgStatsMode = 0;
+
+// Only called with vertex < acc->limit, so the size stays within int
+int growCsrrgStatsAccumulator(CsrrgStatsAccumulator *acc, int vertex) {
+    size_t size = acc->size ? (size_t)acc->size : 1024;
+    while (size <= (size_t)vertex) size *= 2;
+    if (size > (size_t)acc->limit) size = (size_t)acc->limit;
+    int *outDegree = realloc(acc->outDegree, size * sizeof(int));
+    if (!outDegree) {
+        fprintf(stderr, "Memory allocation error for degree counts\n");
+        return -2;
+    }
+    acc->outDegree = outDegree;
+    int *inDegree = realloc(acc->inDegree, size * sizeof(int));
+    if (!inDegree) {
+        fprintf(stderr, "Memory allocation error for degree counts\n");
+        return -2;
+    }
+    acc->inDegree = inDegree;
+    memset(outDegree + acc->size, 0, (size - acc->size) * sizeof(int));
+    memset(inDegree + acc->size, 0, (size - acc->size) * sizeof(int));
+    acc->size = (int)size;
+    return 0;
+}
+
+void freeCsrrgStatsAccumulator(CsrrgStatsAccumulator *acc) {
+    int limit = acc->limit;
+    free(acc->outDegree);
+    free(acc->inDegree);
+    memset(acc, 0, sizeof(*acc));
+    acc->limit = limit;
+}
+
+// Last ';'-separated token of line 3, as buildCsrrgRowCounts will read it
+static int last_row_pointer(const char *line3) {
+    const char *end = line3 + strlen(line3);
+    while (end > line3 && end[-1] == ';') end--;
+    const char *start = end;
+    while (start > line3 && start[-1] != ';') start--;
+    return start < end ? atoi(start) : 0;
+}
+
+void initCsrrgGraphStats(CsrrgGraphStats *stats, const CsrrgHeader *header) {
+    memset(stats, 0, sizeof(*stats));
+    int limit = last_row_pointer(header->line3);
+    stats->total.limit = limit > 0 ? limit : 0;
+}
+
+// Row figures from the counts buildCsrrgRowCounts took from line 3
+void setCsrrgStatsHeader(CsrrgGraphStats *stats, const CsrrgHeader *header) {
+    stats->rows = header->numRows;
+    stats->columns = header->columns;
+    stats->vertexTotal = header->vertexTotal;
+    stats->emptyRows = 0;
+    stats->maxRowEntries = 0;
+    for (int row = 0; row < header->numRows; row++) {
+        int count = header->rowCounts[row];
+        stats->emptyRows += count == 0;
+        if (count > stats->maxRowEntries) stats->maxRowEntries = count;
+    }
+}
+
+int addCsrrgSectionSize(CsrrgGraphStats *stats, const CsrrgSection *section) {
+    if (stats->sectionCount == stats->sectionCapacity) {
+        int capacity = stats->sectionCapacity ? stats->sectionCapacity * 2 : 16;
+        CsrrgSectionSize *temp = realloc(stats->sections, capacity * sizeof(CsrrgSectionSize));
+        if (!temp) {
+            fprintf(stderr, "Memory allocation error for section statistics\n");
+            return -5;
+        }
+        stats->sections = temp;
+        stats->sectionCapacity = capacity;
+    }
+    CsrrgSectionSize *size = &stats->sections[stats->sectionCount++];
+    size->bytes = (long)section->bytes;
+    size->groups = section->groups;
+    size->edges = section->edges;
+    return 0;
+}
+
+int mergeCsrrgStatsAccumulator(CsrrgGraphStats *stats, CsrrgStatsAccumulator *acc) {
+    CsrrgStatsAccumulator *total = &stats->total;
+    int status = 0;
+    if (total->size == 0) {
+        // The first worker's arrays become the total
+        CsrrgStatsAccumulator counts = *total;
+        *total = *acc;
+        total->edges += counts.edges;
+        total->selfLoops += counts.selfLoops;
+        total->negative += counts.negative;
+        total->outOfRange += counts.outOfRange;
+        memset(acc, 0, sizeof(*acc));
+        return 0;
+    }
+    if (acc->size > total->size) status = growCsrrgStatsAccumulator(total, acc->size - 1);
+    if (status == 0) {
+        for (int v = 0; v < acc->size; v++) {
+            total->outDegree[v] += acc->outDegree[v];
+            total->inDegree[v] += acc->inDegree[v];
+        }
+        total->edges += acc->edges;
+        total->selfLoops += acc->selfLoops;
+        total->negative += acc->negative;
+        total->outOfRange += acc->outOfRange;
+    }
+    freeCsrrgStatsAccumulator(acc);
+    return status;
+}
+
+static int degree_bucket(int degree) {
+    int bucket = 0;
+    while (degree > 0) {
+        bucket++;
+        degree >>= 1;
+    }
+    return bucket;
+}
+
+// What is derived from the merged degrees, in one pass over the vertices
+typedef struct DegreeSummary {
+    long outHistogram[CSRRG_DEGREE_BUCKETS];
+    long inHistogram[CSRRG_DEGREE_BUCKETS];
+    int maxOut, maxIn;
+    int minOut, minIn;
+    long isolated;
+    int buckets;       // Highest non-empty bucket + 1
+} DegreeSummary;
+
+static void summarize_degrees(const CsrrgGraphStats *stats, DegreeSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    const CsrrgStatsAccumulator *total = &stats->total;
+    int vertices = stats->vertexTotal;
+    summary->minOut = summary->minIn = vertices > 0 ? -1 : 0;
+    for (int v = 0; v < vertices; v++) {
+        int out = v < total->size ? total->outDegree[v] : 0;
+        int in = v < total->size ? total->inDegree[v] : 0;
+        int outBucket = degree_bucket(out), inBucket = degree_bucket(in);
+        summary->outHistogram[outBucket]++;
+        summary->inHistogram[inBucket]++;
+        if (outBucket >= summary->buckets) summary->buckets = outBucket + 1;
+        if (inBucket >= summary->buckets) summary->buckets = inBucket + 1;
+        if (out > summary->maxOut) summary->maxOut = out;
+        if (in > summary->maxIn) summary->maxIn = in;
+        if (summary->minOut < 0 || out < summary->minOut) summary->minOut = out;
+        if (summary->minIn < 0 || in < summary->minIn) summary->minIn = in;
+        summary->isolated += out == 0 && in == 0;
+    }
+    if (summary->minOut < 0) summary->minOut = summary->minIn = 0;
+}
+
+// "0", "1", "2-3", "4-7", ...
+static void bucket_label(int bucket, char *label, size_t size) {
+    if (bucket <= 1) {
+        snprintf(label, size, "%d", bucket);
+    } else {
+        snprintf(label, size, "%ld-%ld", 1L << (bucket - 1), (1L << bucket) - 1);
+    }
+}
+
+void printCsrrgGraphStats(FILE *out, const char *name, const CsrrgGraphStats *stats, int json) {
+    DegreeSummary summary;
+    summarize_degrees(stats, &summary);
+    long vertices = stats->vertexTotal;
+    double density = vertices > 1 ? (double)stats->total.edges / ((double)vertices * (vertices - 1)) : 0.0;
+    double meanDegree = vertices > 0 ? (double)stats->total.edges / vertices : 0.0;
+
+    if (json) {
+        fprintf(out, "{\"file\": \"%s\", \"rows\": %d, \"emptyRows\": %d, \"maxRowEntries\": %d, "
+                "\"columns\": %d, \"vertices\": %ld, \"edges\": %ld, \"density\": %.9g, \"selfLoops\": %ld, "
+                "\"isolated\": %ld, \"outDegree\": {\"min\": %d, \"mean\": %.6g, \"max\": %d}, "
+                "\"inDegree\": {\"min\": %d, \"mean\": %.6g, \"max\": %d}",
+                name, stats->rows, stats->emptyRows, stats->maxRowEntries, stats->columns, vertices,
+                stats->total.edges, density, stats->total.selfLoops, summary.isolated,
+                summary.minOut, meanDegree, summary.maxOut, summary.minIn, meanDegree, summary.maxIn);
+        if (stats->total.outOfRange > 0 || stats->total.negative > 0) {
+            fprintf(out, ", \"outOfRangeEdges\": %ld, \"negativeEdges\": %ld",
+                    stats->total.outOfRange, stats->total.negative);
+        }
+        const char *names[2] = {"outDegreeHistogram", "inDegreeHistogram"};
+        const long *histograms[2] = {summary.outHistogram, summary.inHistogram};
+        for (int h = 0; h < 2; h++) {
+            fprintf(out, ", \"%s\": {", names[h]);
+            for (int b = 0; b < summary.buckets; b++) {
+                char label[32];
+                bucket_label(b, label, sizeof(label));
+                fprintf(out, "%s\"%s\": %ld", b ? ", " : "", label, histograms[h][b]);
+            }
+            fprintf(out, "}");
+        }
+        fprintf(out, ", \"sections\": [");
+        for (int i = 0; i < stats->sectionCount; i++) {
+            const CsrrgSectionSize *size = &stats->sections[i];
+            fprintf(out, "%s{\"bytes\": %ld, \"groups\": %ld, \"edges\": %ld}",
+                    i ? ", " : "", size->bytes, size->groups, size->edges);
+        }
+        fprintf(out, "]}\n");
+        return;
+    }
+
+    fprintf(out, "%s\n", name);
+    fprintf(out, "  rows:        %d (%d empty, at most %d entries)\n", stats->rows, stats->emptyRows,
+            stats->maxRowEntries);
+    fprintf(out, "  columns:     %d\n", stats->columns);
+    fprintf(out, "  vertices:    %ld (%ld isolated)\n", vertices, summary.isolated);
+    fprintf(out, "  edges:       %ld (%ld self-loops)\n", stats->total.edges, stats->total.selfLoops);
+    fprintf(out, "  density:     %.9g\n", density);
+    fprintf(out, "  out-degree:  min %d, mean %.3f, max %d\n", summary.minOut, meanDegree, summary.maxOut);
+    fprintf(out, "  in-degree:   min %d, mean %.3f, max %d\n", summary.minIn, meanDegree, summary.maxIn);
+    if (stats->total.outOfRange > 0 || stats->total.negative > 0) {
+        fprintf(out, "  warning:     %ld edges reach past the line 3 total, %ld have negative vertices; "
+                "neither is counted above\n", stats->total.outOfRange, stats->total.negative);
+    }
+    fprintf(out, "  degree       vertices (out)  vertices (in)\n");
+    for (int b = 0; b < summary.buckets; b++) {
+        char label[32];
+        bucket_label(b, label, sizeof(label));
+        fprintf(out, "  %-12s %14ld %14ld\n", label, summary.outHistogram[b], summary.inHistogram[b]);
+    }
+    fprintf(out, "  sections:    %d\n", stats->sectionCount);
+    for (int i = 0; i < stats->sectionCount; i++) {
+        const CsrrgSectionSize *size = &stats->sections[i];
+        fprintf(out, "    %d: %ld bytes, %ld groups, %ld edges\n", i + 1, size->bytes, size->groups, size->edges);
+    }
+}
+
+void freeCsrrgGraphStats(CsrrgGraphStats *stats) {
+    freeCsrrgStatsAccumulator(&stats->total);
+    free(stats->sections);
+    stats->sections = NULL;
+    stats->sectionCount = stats->sectionCapacity = 0;
+}
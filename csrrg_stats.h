@@ -0,0 +1,79 @@
+#ifndef CSRRG_STATS_H
+#define CSRRG_STATS_H
+
+#include <stdio.h>
+#include "csrrg.h"
+
+#define CSRRG_DEGREE_BUCKETS 33  // Degree 0, then [2^k, 2^(k+1)) for k = 0..31
+
+// Set by --graph-stats (1) or --graph-stats=json (2)
+extern int csrrgStatsMode;
+
+/* Degrees and counts gathered by one pipeline worker from the edges it
+   parses. The arrays grow to the highest vertex seen, never past limit. */
+typedef struct CsrrgStatsAccumulator {
+    int size;         // Entries in outDegree and inDegree
+    int limit;        // Line 3 total; vertices from here on are out of range
+    int *outDegree;
+    int *inDegree;
+    long edges;
+    long selfLoops;
+    long negative;    // Edges with a negative vertex, left out of the degrees
+    long outOfRange;  // Edges with a vertex at or past limit, likewise
+} CsrrgStatsAccumulator;
+
+typedef struct CsrrgSectionSize {
+    long bytes;       // Edge line plus pointer line, line ends included
+    long groups;      // Non-empty groups
+    long edges;
+} CsrrgSectionSize;
+
+/* Statistics of one .csrrg graph, filled while processCsrrgFile converts
+   it: the row figures come from line 3, everything about edges from the
+   worker accumulators merged at the end. */
+typedef struct CsrrgGraphStats {
+    int rows;
+    int columns;
+    int vertexTotal;
+    int emptyRows;
+    int maxRowEntries;
+    CsrrgSectionSize *sections;
+    int sectionCount;
+    int sectionCapacity;
+    CsrrgStatsAccumulator total;
+} CsrrgGraphStats;
+
+int growCsrrgStatsAccumulator(CsrrgStatsAccumulator *acc, int vertex);
+void freeCsrrgStatsAccumulator(CsrrgStatsAccumulator *acc);
+
+// Counts one edge; returns -2 if the degree arrays cannot grow
+static inline int csrrgStatsAddEdge(CsrrgStatsAccumulator *acc, int src, int dest) {
+    if (src < 0 || dest < 0) {
+        acc->negative++;
+        return 0;
+    }
+    if (src >= acc->limit || dest >= acc->limit) {
+        acc->outOfRange++;
+        return 0;
+    }
+    int high = src > dest ? src : dest;
+    if (high >= acc->size && growCsrrgStatsAccumulator(acc, high) != 0) return -2;
+    acc->outDegree[src]++;
+    acc->inDegree[dest]++;
+    acc->edges++;
+    acc->selfLoops += src == dest;
+    return 0;
+}
+
+/* Takes the vertex limit from the last pointer of line 3, which is still
+   unparsed when the pipeline workers start. */
+void initCsrrgGraphStats(CsrrgGraphStats *stats, const CsrrgHeader *header);
+void setCsrrgStatsHeader(CsrrgGraphStats *stats, const CsrrgHeader *header);
+int addCsrrgSectionSize(CsrrgGraphStats *stats, const CsrrgSection *section);
+// Adds a worker's counts to the total and frees them
+int mergeCsrrgStatsAccumulator(CsrrgGraphStats *stats, CsrrgStatsAccumulator *acc);
+// Text report, or one JSON object with json set
+void printCsrrgGraphStats(FILE *out, const char *name, const CsrrgGraphStats *stats, int json);
+void freeCsrrgGraphStats(CsrrgGraphStats *stats);
+
+#endif // CSRRG_STATS_H
@@ -0,0 +1,331 @@
+#include "csrrg_validate.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+
+#define CHECKSUM_PRIME 0x9E3779B97F4A7C15ULL
+
+static uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/* 64-bit checksum of data. Four lanes of 8-byte words keep several
+   multiplies in flight, so it runs at several bytes per cycle. */
+uint64_t csrrgChecksum(const char *data, size_t length, uint64_t seed) {
+    uint64_t lanes[4] = {seed ^ 0x243F6A8885A308D3ULL, seed ^ 0x13198A2E03707344ULL,
+                         seed ^ 0xA4093822299F31D0ULL, seed ^ 0x082EFA98EC4E6C89ULL};
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (int k = 0; k < 4; k++) {
+            uint64_t word;
+            memcpy(&word, data + i + 8 * k, sizeof(word));
+            lanes[k] = rotate_left(lanes[k] ^ word, 29) * CHECKSUM_PRIME;
+        }
+    }
+    uint64_t hash = seed ^ length;
+    for (int k = 0; k < 4; k++) {
+        hash = rotate_left(hash ^ lanes[k], 31) * CHECKSUM_PRIME;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * 0x100000001B3ULL;
+    }
+    // splitmix64 finalizer
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// Length of line without the trailing newline and spaces
+static size_t content_length(const char *line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ')) {
+        length--;
+    }
+    return length;
+}
+
+/* Parses a ';'-separated list of non-negative integers. Empty tokens are
+   skipped, as strtok does for the converter. On error returns -1 and
+   *bad points at the offending character. */
+static int parse_tokens(const char *line, int **values, long *count, const char **bad) {
+    *values = malloc((strlen(line) / 2 + 1) * sizeof(int));
+    *count = 0;
+    if (!*values) {
+        fprintf(stderr, "Memory allocation error for validation\n");
+        return -2;
+    }
+    long long current = 0;
+    int inToken = 0;
+    for (const char *p = line; ; p++) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            current = current * 10 + (c - '0');
+            if (current > INT_MAX) {
+                *bad = p;
+                return -1;
+            }
+            inToken = 1;
+        } else if (c == ';' || c == '\0' || c == '\n') {
+            if (inToken) (*values)[(*count)++] = (int)current;
+            current = 0;
+            inToken = 0;
+            if (c != ';') break;
+        } else if (c != ' ' && c != '\t' && c != '\r') {
+            *bad = p;
+            return -1;
+        }
+    }
+    STATS_ADD(STATS_TOKENS_PARSED, *count);
+    return 0;
+}
+
+/* The two checks below are plain reductions without early exits, so the
+   compiler turns them into vector compares; the scalar search for the
+   exact position only runs once a problem is known to exist. */
+static int max_value(const int *values, long count) {
+    int max = -1;
+    for (long i = 0; i < count; i++) {
+        max = values[i] > max ? values[i] : max;
+    }
+    return max;
+}
+
+// Index of the first value smaller than its predecessor, or -1
+static long first_decrease(const int *values, long count) {
+    long decreases = 0;
+    for (long i = 1; i < count; i++) {
+        decreases += values[i] < values[i - 1];
+    }
+    if (decreases == 0) return -1;
+    for (long i = 1; i < count; i++) {
+        if (values[i] < values[i - 1]) return i;
+    }
+    return -1;
+}
+
+/* Pointer list checks shared by line 3 and the group pointers: at least
+   one pointer, the first is 0 and none is smaller than the one before. */
+static int check_pointers(const char *what, const int *pointers, long count) {
+    if (count == 0) {
+        fprintf(stderr, "%s: no pointers\n", what);
+        return -1;
+    }
+    if (pointers[0] != 0) {
+        fprintf(stderr, "%s: first pointer is %d, expected 0\n", what, pointers[0]);
+        return -1;
+    }
+    long i = first_decrease(pointers, count);
+    if (i >= 0) {
+        fprintf(stderr, "%s: pointer %ld (%d) is smaller than pointer %ld (%d)\n",
+                what, i, pointers[i], i - 1, pointers[i - 1]);
+        return -1;
+    }
+    return 0;
+}
+
+static void report_bad_token(const char *what, const char *line, const char *bad) {
+    fprintf(stderr, "%s: invalid token at column %ld\n", what, (long)(bad - line) + 1);
+}
+
+int validateCsrrgHeader(const CsrrgHeader *header, CsrrgValidation *report) {
+    report->rows = 0;
+    report->columns = 0;
+    report->vertexTotal = 0;
+    memset(&report->header, 0, sizeof(report->header));
+    if (header->maxRowNodes < 0) {
+        fprintf(stderr, "Header line 1: negative row size %d\n", header->maxRowNodes);
+        return -1;
+    }
+
+    int *indices = NULL, *pointers = NULL;
+    long indexCount = 0, pointerCount = 0;
+    const char *bad = NULL;
+    int status = parse_tokens(header->line2, &indices, &indexCount, &bad);
+    if (status == -1) report_bad_token("Header line 2", header->line2, bad);
+    if (status == 0) {
+        status = parse_tokens(header->line3, &pointers, &pointerCount, &bad);
+        if (status == -1) report_bad_token("Header line 3", header->line3, bad);
+    }
+    if (status == 0) status = check_pointers("Header line 3", pointers, pointerCount);
+    if (status == 0 && pointers[pointerCount - 1] != indexCount) {
+        fprintf(stderr, "Header line 3: last row pointer is %d but line 2 has %ld indices\n",
+                pointers[pointerCount - 1], indexCount);
+        status = -1;
+    }
+    if (status == 0) {
+        report->rows = (int)pointerCount - 1;
+        report->columns = max_value(indices, indexCount) + 1;
+        report->vertexTotal = (int)indexCount;
+        report->header.tokens = indexCount + pointerCount;
+        uint64_t checksum = csrrgChecksum(header->line2, content_length(header->line2), (uint64_t)header->maxRowNodes);
+        report->header.checksum = csrrgChecksum(header->line3, content_length(header->line3), checksum);
+    }
+    free(indices);
+    free(pointers);
+    return status;
+}
+
+/* Checks one edge section before formatCsrrgEdgeSection tokenizes it.
+   `index` is the 1-based section number used in messages. */
+int validateCsrrgSection(const CsrrgSection *section, int index, int vertexTotal, CsrrgSectionInfo *info) {
+    memset(info, 0, sizeof(*info));
+    char what[64];
+    int *vertices = NULL, *pointers = NULL;
+    long vertexCount = 0, pointerCount = 0;
+    const char *bad = NULL;
+
+    snprintf(what, sizeof(what), "Edge section %d, edge line", index);
+    int status = parse_tokens(section->edgeLine, &vertices, &vertexCount, &bad);
+    if (status == -1) report_bad_token(what, section->edgeLine, bad);
+    if (status == 0) {
+        snprintf(what, sizeof(what), "Edge section %d, pointer line", index);
+        status = parse_tokens(section->pointerLine, &pointers, &pointerCount, &bad);
+        if (status == -1) report_bad_token(what, section->pointerLine, bad);
+    }
+    if (status == 0) status = check_pointers(what, pointers, pointerCount);
+    if (status == 0 && pointers[pointerCount - 1] > vertexCount) {
+        fprintf(stderr, "%s: last pointer is %d but the edge line has %ld vertices\n",
+                what, pointers[pointerCount - 1], vertexCount);
+        status = -1;
+    }
+    if (status == 0) {
+        int max = max_value(vertices, vertexCount);
+        if (max >= vertexTotal) {
+            fprintf(stderr, "Edge section %d: vertex %d out of range, the header defines %d\n",
+                    index, max, vertexTotal);
+            status = -1;
+        }
+    }
+    if (status == 0) {
+        // A group runs between two pointers, as formatCsrrgEdgeSection reads it
+        for (long i = 0; i + 1 < pointerCount; i++) {
+            long size = pointers[i + 1] - pointers[i];
+            if (size > 0) {
+                info->groups++;
+                info->edges += size - 1;
+            }
+        }
+        long last = pointers[pointerCount - 1];
+        info->ignored = vertexCount - last;
+        if (info->ignored > 0) {
+            fprintf(stderr, "Edge section %d: warning, %ld token(s) after the last pointer are ignored\n",
+                    index, info->ignored);
+        }
+        info->tokens = last + pointerCount;
+        uint64_t checksum = csrrgChecksum(section->edgeLine, content_length(section->edgeLine), (uint64_t)index);
+        info->checksum = csrrgChecksum(section->pointerLine, content_length(section->pointerLine), checksum);
+    }
+    free(vertices);
+    free(pointers);
+    return status;
+}
+
+/* Standalone pass over a whole file. Every section is checked even after
+   an error; report->errors counts the invalid parts. */
+int validateCsrrgFile(FILE *f, CsrrgValidation *report) {
+    memset(report, 0, sizeof(*report));
+    CsrrgHeader header;
+    int status = readCsrrgHeader(f, &header);
+    if (status != 0) {
+        report->errors = 1;
+        return status;
+    }
+    // Without a valid header there is no vertex count to check the sections against
+    int vertexLimit = INT_MAX;
+    if (validateCsrrgHeader(&header, report) != 0) {
+        report->errors++;
+    } else {
+        vertexLimit = report->vertexTotal;
+    }
+    freeCsrrgHeader(&header);
+
+    char *edgeLine = NULL, *pointerLine = NULL;
+    size_t edgeCapacity = 0, pointerCapacity = 0;
+    int capacity = 0;
+    status = 0;
+    while ((status = readCsrrgLine(f, &edgeLine, &edgeCapacity)) > 0) {
+        int index = report->sectionCount + 1;
+        status = readCsrrgLine(f, &pointerLine, &pointerCapacity);
+        if (status < 0) break;
+        if (status == 0) {
+            fprintf(stderr, "Edge section %d: edge line without a pointer line\n", index);
+            report->errors++;
+            break;
+        }
+        if (report->sectionCount == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            CsrrgSectionInfo *temp = realloc(report->sections, capacity * sizeof(CsrrgSectionInfo));
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error for validation report\n");
+                status = -5;
+                break;
+            }
+            report->sections = temp;
+        }
+        CsrrgSection section = {0};
+        section.edgeLine = edgeLine;
+        section.pointerLine = pointerLine;
+        int valid = validateCsrrgSection(&section, index, vertexLimit, &report->sections[report->sectionCount]);
+        if (valid < -1) {
+            status = valid;
+            break;
+        }
+        if (valid != 0) report->errors++;
+        report->sectionCount++;
+    }
+    free(edgeLine);
+    free(pointerLine);
+    if (status < 0) return status;
+    return report->errors ? -1 : 0;
+}
+
+void printCsrrgValidation(FILE *out, const char *name, const CsrrgValidation *report) {
+    if (report->errors) {
+        fprintf(out, "%s: invalid, %d error(s)\n", name, report->errors);
+    } else {
+        fprintf(out, "%s: valid\n", name);
+    }
+    fprintf(out, "  header: %d rows, %d columns, %ld tokens, checksum %016llx\n", report->rows,
+            report->columns, report->header.tokens, (unsigned long long)report->header.checksum);
+    for (int i = 0; i < report->sectionCount; i++) {
+        const CsrrgSectionInfo *info = &report->sections[i];
+        fprintf(out, "  section %d: %ld tokens, %ld groups, %ld edges, checksum %016llx", i + 1,
+                info->tokens, info->groups, info->edges, (unsigned long long)info->checksum);
+        if (info->ignored) fprintf(out, ", %ld ignored after the last pointer", info->ignored);
+        fputc('\n', out);
+    }
+}
+
+void freeCsrrgValidation(CsrrgValidation *report) {
+    free(report->sections);
+    report->sections = NULL;
+    report->sectionCount = 0;
+}
+
+int checkCsrrgFiles(int count, char **files) {
+    if (count == 0) {
+        fprintf(stderr, "Usage: --check file.csrrg [file.csrrg ...]\n");
+        return -1;
+    }
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        FILE *f = fopen(files[i], "r");
+        if (!f) {
+            fprintf(stderr, "Error opening file %s\n", files[i]);
+            result = -4;
+            continue;
+        }
+        CsrrgValidation report;
+        int status = validateCsrrgFile(f, &report);
+        fclose(f);
+        printCsrrgValidation(stdout, files[i], &report);
+        freeCsrrgValidation(&report);
+        if (status != 0 && result == 0) result = status;
+    }
+    return result;
+}
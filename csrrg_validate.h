@@ -0,0 +1,43 @@
+#ifndef CSRRG_VALIDATE_H
+#define CSRRG_VALIDATE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "csrrg.h"
+
+// What validation found in the header or in one edge section
+typedef struct CsrrgSectionInfo {
+    long tokens;
+    long groups;        // Non-empty groups, an edge section only
+    long edges;
+    long ignored;       // Edge line tokens after the last pointer, dropped by the converter
+    uint64_t checksum;  // csrrgChecksum of the section's lines
+} CsrrgSectionInfo;
+
+typedef struct CsrrgValidation {
+    int rows;
+    int columns;        // Highest index in line 2 + 1
+    int vertexTotal;    // Last row pointer, bound for edge section vertices
+    CsrrgSectionInfo header;
+    CsrrgSectionInfo *sections;
+    int sectionCount;
+    int errors;
+} CsrrgValidation;
+
+uint64_t csrrgChecksum(const char *data, size_t length, uint64_t seed);
+
+/* Structural checks: numeric tokens, row/group pointers starting at 0 and
+   never decreasing, pointer totals matching the token counts, vertices in
+   range and complete edge sections. Errors are reported on stderr; the
+   functions return 0 when valid and -1 otherwise (other negatives for I/O
+   or allocation errors). Neither modifies the lines it checks. */
+int validateCsrrgHeader(const CsrrgHeader *header, CsrrgValidation *report);
+int validateCsrrgSection(const CsrrgSection *section, int index, int vertexTotal, CsrrgSectionInfo *info);
+int validateCsrrgFile(FILE *f, CsrrgValidation *report);
+void printCsrrgValidation(FILE *out, const char *name, const CsrrgValidation *report);
+void freeCsrrgValidation(CsrrgValidation *report);
+
+// graph_gen --check file.csrrg...
+int checkCsrrgFiles(int count, char **files);
+
+#endif // CSRRG_VALIDATE_H
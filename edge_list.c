@@ -0,0 +1,456 @@
+#include "edge_list.h"
+#include "stats.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define EDGE_LIST_CHUNK (16 << 20)         // Bytes read per fread
+#define EDGE_LIST_PARALLEL_MIN (1 << 20)   // Smaller chunks are parsed on one thread
+#define EDGE_LIST_MAX_THREADS 64
+
+/* Labels seen by the thread of one slice position, kept from chunk to
+   chunk so each is interned and mapped once. global[i] is the id in the
+   shared interner of local id i, known for the first `mapped` ids. */
+typedef struct SliceLabels {
+    LabelInterner local;
+    int *global;
+    int mapped;
+    int capacity;
+} SliceLabels;
+
+/* Lines [begin, end) of a chunk and what one thread parsed out of them:
+   two ids per edge. In label mode the ids are local ones from `labels`,
+   interned by the parsing thread, and become global when the slices are
+   merged. */
+typedef struct EdgeSlice {
+    const char *chunk;
+    size_t begin;
+    size_t end;
+    int flags;
+    int *ids;
+    SliceLabels *labels;  // Label mode only
+    int count;       // Entries used (2 * edges)
+    int capacity;
+    int malformed;   // Lines that are not "src dst"
+    int failed;      // Allocation failure
+} EdgeSlice;
+
+/* Growable src/dst arrays for the whole input. */
+typedef struct EdgeBuffer {
+    int *src;
+    int *dst;
+    int count;
+    int capacity;
+    int maxId;
+} EdgeBuffer;
+
+uint64_t hashLabel(const char *label, size_t length) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)label[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int initLabelInterner(LabelInterner *labels) {
+    memset(labels, 0, sizeof(*labels));
+    labels->poolCapacity = 4096;
+    labels->capacity = 256;
+    labels->tableMask = 511;
+    labels->pool = malloc(labels->poolCapacity);
+    labels->offsets = malloc(labels->capacity * sizeof(size_t));
+    labels->hashes = malloc(labels->capacity * sizeof(uint64_t));
+    labels->table = malloc((labels->tableMask + 1) * sizeof(int));
+    if (!labels->pool || !labels->offsets || !labels->hashes || !labels->table) {
+        fprintf(stderr, "Memory allocation error for label interner\n");
+        freeLabelInterner(labels);
+        return -2;
+    }
+    memset(labels->table, -1, (labels->tableMask + 1) * sizeof(int));
+    return 0;
+}
+
+static int grow_label_table(LabelInterner *labels) {
+    size_t newMask = labels->tableMask * 2 + 1;
+    int *table = malloc((newMask + 1) * sizeof(int));
+    if (!table) return -2;
+    memset(table, -1, (newMask + 1) * sizeof(int));
+    for (int id = 0; id < labels->count; id++) {
+        size_t slot = labels->hashes[id] & newMask;
+        while (table[slot] >= 0) slot = (slot + 1) & newMask;
+        table[slot] = id;
+    }
+    free(labels->table);
+    labels->table = table;
+    labels->tableMask = newMask;
+    return 0;
+}
+
+/* Returns the id of the label, adding it if it was not seen before, or -2
+   on allocation failure. `hash` must be hashLabel(label, length). */
+int internLabel(LabelInterner *labels, const char *label, size_t length, uint64_t hash) {
+    size_t slot = hash & labels->tableMask;
+    for (int id = labels->table[slot]; id >= 0; id = labels->table[slot]) {
+        const char *name = labels->pool + labels->offsets[id];
+        if (labels->hashes[id] == hash && strncmp(name, label, length) == 0 && name[length] == '\0') {
+            return id;
+        }
+        slot = (slot + 1) & labels->tableMask;
+    }
+    if (labels->count == INT_MAX) return -2;
+
+    if (labels->count >= labels->capacity) {
+        int capacity = labels->capacity * 2;
+        size_t *offsets = realloc(labels->offsets, capacity * sizeof(size_t));
+        if (!offsets) return -2;
+        labels->offsets = offsets;
+        uint64_t *hashes = realloc(labels->hashes, capacity * sizeof(uint64_t));
+        if (!hashes) return -2;
+        labels->hashes = hashes;
+        labels->capacity = capacity;
+    }
+    if (labels->poolSize + length + 1 > labels->poolCapacity) {
+        size_t capacity = labels->poolCapacity * 2;
+        while (capacity < labels->poolSize + length + 1) capacity *= 2;
+        char *pool = realloc(labels->pool, capacity);
+        if (!pool) return -2;
+        labels->pool = pool;
+        labels->poolCapacity = capacity;
+    }
+
+    int id = labels->count++;
+    labels->offsets[id] = labels->poolSize;
+    labels->hashes[id] = hash;
+    memcpy(labels->pool + labels->poolSize, label, length);
+    labels->pool[labels->poolSize + length] = '\0';
+    labels->poolSize += length + 1;
+    labels->table[slot] = id;
+
+    // Keep the load factor under one half
+    if ((size_t)labels->count * 2 > labels->tableMask && grow_label_table(labels) != 0) return -2;
+    return id;
+}
+
+const char *labelName(const LabelInterner *labels, int id) {
+    return labels->pool + labels->offsets[id];
+}
+
+void freeLabelInterner(LabelInterner *labels) {
+    free(labels->pool);
+    free(labels->offsets);
+    free(labels->hashes);
+    free(labels->table);
+    memset(labels, 0, sizeof(*labels));
+}
+
+static int is_separator(const char *p, const char *end) {
+    return *p == ' ' || *p == '\t' || *p == '\r' || *p == ',' || *p == ';' ||
+           (*p == '-' && p + 1 < end && p[1] == '>');
+}
+
+// Advances past a label and returns its length (0 if there is none)
+static size_t scan_label(const char **p, const char *end) {
+    const char *start = *p;
+    while (*p < end && !is_separator(*p, end)) (*p)++;
+    return *p - start;
+}
+
+static void skip_separators(const char **p, const char *end) {
+    while (*p < end && is_separator(*p, end)) {
+        *p += **p == '-' ? 2 : 1;
+    }
+}
+
+static int parse_vertex_number(const char *label, size_t length) {
+    long long value = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (label[i] < '0' || label[i] > '9') return -1;
+        value = value * 10 + (label[i] - '0');
+        if (value >= INT_MAX) return -1;
+    }
+    return (int)value;
+}
+
+static int slice_reserve(EdgeSlice *slice) {
+    if (slice->count + 2 <= slice->capacity) return 0;
+    int capacity = slice->capacity ? slice->capacity * 2 : 4096;
+    int *ids = realloc(slice->ids, capacity * sizeof(int));
+    if (!ids) return -2;
+    slice->ids = ids;
+    slice->capacity = capacity;
+    return 0;
+}
+
+/* Parses "src dst" lines. Labels are separated by spaces, tabs, ',', ';'
+   or "->"; anything after the second label (e.g. a weight) is ignored.
+   Blank lines and lines starting with '#' or '%' are skipped. */
+static void *parse_slice(void *arg) {
+    EdgeSlice *slice = arg;
+    const char *p = slice->chunk + slice->begin;
+    const char *end = slice->chunk + slice->end;
+
+    while (p < end) {
+        const char *lineEnd = memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+
+        skip_separators(&p, lineEnd);
+        if (p < lineEnd && *p != '#' && *p != '%') {
+            const char *src = p;
+            size_t srcLen = scan_label(&p, lineEnd);
+            skip_separators(&p, lineEnd);
+            const char *dst = p;
+            size_t dstLen = scan_label(&p, lineEnd);
+
+            if (srcLen == 0 || dstLen == 0) {
+                slice->malformed++;
+            } else if (slice_reserve(slice) != 0) {
+                slice->failed = 1;
+                return NULL;
+            } else if (slice->flags & EDGE_LIST_NUMERIC) {
+                int s = parse_vertex_number(src, srcLen);
+                int d = parse_vertex_number(dst, dstLen);
+                if (s < 0 || d < 0) {
+                    slice->malformed++;
+                } else {
+                    slice->ids[slice->count++] = s;
+                    slice->ids[slice->count++] = d;
+                }
+            } else {
+                LabelInterner *local = &slice->labels->local;
+                int s = internLabel(local, src, srcLen, hashLabel(src, srcLen));
+                int d = internLabel(local, dst, dstLen, hashLabel(dst, dstLen));
+                if (s < 0 || d < 0) {
+                    slice->failed = 1;
+                    return NULL;
+                }
+                slice->ids[slice->count++] = s;
+                slice->ids[slice->count++] = d;
+            }
+        }
+        p = lineEnd + 1;
+    }
+    return NULL;
+}
+
+static int append_edge(EdgeBuffer *edges, int src, int dst) {
+    if (edges->count >= edges->capacity) {
+        if (edges->capacity >= INT_MAX / 2) return -5;
+        int capacity = edges->capacity ? edges->capacity * 2 : 65536;
+        int *s = realloc(edges->src, capacity * sizeof(int));
+        if (!s) return -5;
+        edges->src = s;
+        int *d = realloc(edges->dst, capacity * sizeof(int));
+        if (!d) return -5;
+        edges->dst = d;
+        edges->capacity = capacity;
+    }
+    edges->src[edges->count] = src;
+    edges->dst[edges->count] = dst;
+    edges->count++;
+    if (src > edges->maxId) edges->maxId = src;
+    if (dst > edges->maxId) edges->maxId = dst;
+    return 0;
+}
+
+/* Interns the labels a slice thread met for the first time into the shared
+   table, in local id order, so global ids still follow the order labels
+   first appear in the input. Each distinct label costs one probe here, not
+   each occurrence. */
+static int map_slice_labels(SliceLabels *slice, LabelInterner *labels) {
+    const LabelInterner *local = &slice->local;
+    if (local->count > slice->capacity) {
+        int capacity = local->capacity;
+        int *global = realloc(slice->global, capacity * sizeof(int));
+        if (!global) return -2;
+        slice->global = global;
+        slice->capacity = capacity;
+    }
+    for (int id = slice->mapped; id < local->count; id++) {
+        size_t end = id + 1 < local->count ? local->offsets[id + 1] : local->poolSize;
+        size_t length = end - local->offsets[id] - 1;
+        slice->global[id] = internLabel(labels, labelName(local, id), length, local->hashes[id]);
+        if (slice->global[id] < 0) return -2;
+    }
+    slice->mapped = local->count;
+    return 0;
+}
+
+/* Parses the complete lines in chunk[0, length) on up to `threads` threads,
+   each interning labels into its own entry of sliceLabels, then merges the
+   slices in order so ids follow the order labels appear. */
+static int process_chunk(const char *chunk, size_t length, int flags, int threads, EdgeBuffer *edges,
+                         LabelInterner *labels, SliceLabels *sliceLabels, int *malformed) {
+    int sliceCount = threads > 1 && length >= EDGE_LIST_PARALLEL_MIN ? threads : 1;
+    EdgeSlice slices[EDGE_LIST_MAX_THREADS];
+    pthread_t handles[EDGE_LIST_MAX_THREADS];
+    int started[EDGE_LIST_MAX_THREADS];
+
+    size_t begin = 0;
+    for (int i = 0; i < sliceCount; i++) {
+        size_t end = i == sliceCount - 1 ? length : length / sliceCount * (i + 1);
+        if (end < begin) end = begin;
+        // Move the split point to the end of the line it falls in
+        while (end < length && end > 0 && chunk[end - 1] != '\n') end++;
+        memset(&slices[i], 0, sizeof(EdgeSlice));
+        slices[i].chunk = chunk;
+        slices[i].begin = begin;
+        slices[i].end = end;
+        slices[i].flags = flags;
+        slices[i].labels = &sliceLabels[i];
+        begin = end;
+    }
+
+    for (int i = 1; i < sliceCount; i++) {
+        started[i] = pthread_create(&handles[i], NULL, parse_slice, &slices[i]) == 0;
+    }
+    parse_slice(&slices[0]);
+    for (int i = 1; i < sliceCount; i++) {
+        if (started[i]) {
+            pthread_join(handles[i], NULL);
+        } else {
+            parse_slice(&slices[i]);
+        }
+    }
+
+    int status = 0;
+    for (int i = 0; i < sliceCount; i++) {
+        EdgeSlice *slice = &slices[i];
+        *malformed += slice->malformed;
+        if (slice->failed) status = -2;
+        const int *global = NULL;
+        if (status == 0 && !(flags & EDGE_LIST_NUMERIC)) {
+            status = map_slice_labels(slice->labels, labels);
+            global = slice->labels->global;
+        }
+        for (int k = 0; k + 1 < slice->count && status == 0; k += 2) {
+            int s = slice->ids[k], d = slice->ids[k + 1];
+            if (global) {
+                s = global[s];
+                d = global[d];
+            }
+            status = append_edge(edges, s, d);
+        }
+        free(slice->ids);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Memory allocation error while reading edge list\n");
+    }
+    return status;
+}
+
+/* Reads an edge list in one streaming pass and builds its CSR graph.
+   Without EDGE_LIST_NUMERIC every label is interned into `labels` and
+   vertex i is labelName(labels, i); with it labels must be non-negative
+   integers and `labels` may be NULL. Duplicate edges are kept. */
+int readEdgeList(FILE *file, int flags, int threads, SparseGraph *graph, LabelInterner *labels) {
+    if (threads < 1) threads = 1;
+    if (threads > EDGE_LIST_MAX_THREADS) threads = EDGE_LIST_MAX_THREADS;
+#ifdef _SC_NPROCESSORS_ONLN
+    // Every parser keeps a label table of its own, more than there are CPUs only costs memory
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && threads > cpus) threads = (int)cpus;
+#endif
+    if (!(flags & EDGE_LIST_NUMERIC) && !labels) {
+        fprintf(stderr, "Label interner required for non-numeric edge lists\n");
+        return -1;
+    }
+
+    size_t capacity = EDGE_LIST_CHUNK;
+    char *buffer = malloc(capacity);
+    if (!buffer) {
+        fprintf(stderr, "Memory allocation error for edge list buffer\n");
+        return -2;
+    }
+
+    SliceLabels *sliceLabels = NULL;
+    if (!(flags & EDGE_LIST_NUMERIC)) {
+        sliceLabels = calloc(threads, sizeof(SliceLabels));
+        int ready = 0;
+        while (sliceLabels && ready < threads && initLabelInterner(&sliceLabels[ready].local) == 0) ready++;
+        if (!sliceLabels || ready < threads) {
+            for (int i = 0; sliceLabels && i < ready; i++) freeLabelInterner(&sliceLabels[i].local);
+            free(sliceLabels);
+            free(buffer);
+            fprintf(stderr, "Memory allocation error for edge list labels\n");
+            return -2;
+        }
+    }
+
+    EdgeBuffer edges = {NULL, NULL, 0, 0, -1};
+    int malformed = 0;
+    int status = 0;
+    size_t carry = 0;   // Bytes of an unfinished line kept from the previous read
+    while (status == 0) {
+        if (capacity - carry < EDGE_LIST_CHUNK / 2) {
+            // A single line longer than the buffer, make room for the rest of it
+            char *temp = realloc(buffer, capacity * 2);
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error during edge list buffer realloc\n");
+                status = -5;
+                break;
+            }
+            buffer = temp;
+            capacity *= 2;
+        }
+        size_t got = fread(buffer + carry, 1, capacity - carry, file);
+        size_t total = carry + got;
+        STATS_ADD(STATS_BYTES_READ, got);
+        if (got == 0) {
+            if (ferror(file)) {
+                fprintf(stderr, "Error reading edge list\n");
+                status = -4;
+            } else if (total > 0) {
+                status = process_chunk(buffer, total, flags, threads, &edges, labels, sliceLabels, &malformed);
+            }
+            break;
+        }
+
+        size_t complete = total;
+        while (complete > 0 && buffer[complete - 1] != '\n') complete--;
+        if (complete == 0) {
+            carry = total;
+            continue;
+        }
+        status = process_chunk(buffer, complete, flags, threads, &edges, labels, sliceLabels, &malformed);
+        carry = total - complete;
+        memmove(buffer, buffer + complete, carry);
+    }
+    free(buffer);
+    for (int i = 0; sliceLabels && i < threads; i++) {
+        freeLabelInterner(&sliceLabels[i].local);
+        free(sliceLabels[i].global);
+    }
+    free(sliceLabels);
+
+    if (malformed > 0) {
+        fprintf(stderr, "Skipped %d malformed edge list line(s)\n", malformed);
+    }
+    STATS_ADD(STATS_TOKENS_PARSED, 2 * (uint64_t)edges.count);
+    if (status == 0) {
+        int n = (flags & EDGE_LIST_NUMERIC) ? edges.maxId + 1 : labels->count;
+        status = buildSparseGraph(n, edges.src, edges.dst, edges.count, graph);
+    }
+    free(edges.src);
+    free(edges.dst);
+    return status;
+}
+
+int readEdgeListFile(const char *fileName, int flags, int threads, SparseGraph *graph, LabelInterner *labels) {
+    if (strcmp(fileName, "-") == 0) {
+        return readEdgeList(stdin, flags, threads, graph, labels);
+    }
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", fileName);
+        return -4;
+    }
+    int status = readEdgeList(f, flags, threads, graph, labels);
+    fclose(f);
+    return status;
+}
@@ -0,0 +1,33 @@
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sparse_graph.h"
+
+#define EDGE_LIST_NUMERIC 1  // Labels are vertex numbers, used as indices directly
+
+// Maps vertex labels to dense ids 0..count-1 in order of first appearance
+typedef struct LabelInterner {
+    char *pool;            // All label bytes, each followed by '\0'
+    size_t poolSize;
+    size_t poolCapacity;
+    size_t *offsets;       // Start of each label in pool, indexed by id
+    uint64_t *hashes;
+    int count;
+    int capacity;
+    int *table;            // Open addressing table of ids, -1 = empty slot
+    size_t tableMask;
+} LabelInterner;
+
+int initLabelInterner(LabelInterner *labels);
+uint64_t hashLabel(const char *label, size_t length);
+int internLabel(LabelInterner *labels, const char *label, size_t length, uint64_t hash);
+const char *labelName(const LabelInterner *labels, int id);
+void freeLabelInterner(LabelInterner *labels);
+
+int readEdgeList(FILE *file, int flags, int threads, SparseGraph *graph, LabelInterner *labels);
+int readEdgeListFile(const char *fileName, int flags, int threads, SparseGraph *graph, LabelInterner *labels);
+
+#endif // EDGE_LIST_H
@@ -0,0 +1,201 @@
+#include "graph_fingerprint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csrrg_validate.h"
+
+#define EXACT_HASH_TAG 0x45584143545F4847ULL  // Keeps exact and WL hashes of one graph apart
+#define WL_HASH_TAG 0x574C5F4841534831ULL
+#define WL_MAX_ROUNDS 64
+#define FINGERPRINT_MIN_SLOTS 64
+
+// splitmix64 finalizer, spreads a colour before it is summed into a multiset
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static int compare_colours(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts colours in place and returns the number of distinct values
+static int count_distinct(uint64_t *colours, int n) {
+    qsort(colours, n, sizeof(uint64_t), compare_colours);
+    int distinct = n > 0;
+    for (int i = 1; i < n; i++) {
+        distinct += colours[i] != colours[i - 1];
+    }
+    return distinct;
+}
+
+// Chained row by row, so the hash does not depend on how the rows are laid out
+uint64_t exactGraphHash(const AdjacencyMatrix *matrix) {
+    int n = matrix->n;
+    uint64_t hash = EXACT_HASH_TAG ^ (uint64_t)n;
+    for (int i = 0; i < n; i++) {
+        hash = csrrgChecksum((const char *)matrix->matrix[i], (size_t)n * sizeof(int), hash);
+    }
+    return hash;
+}
+
+uint64_t exactSparseGraphHash(const SparseGraph *graph) {
+    uint64_t hash = EXACT_HASH_TAG ^ ((uint64_t)graph->n << 32) ^ (uint64_t)graph->m;
+    hash = csrrgChecksum((const char *)graph->rowPtr, (size_t)(graph->n + 1) * sizeof(int), hash);
+    return csrrgChecksum((const char *)graph->colIdx, (size_t)graph->m * sizeof(int), hash);
+}
+
+/* WL refinement over out-edges given in CSR form. The in-edges are built
+   here by transposing. At least one round runs, so the colours hashed
+   always describe the neighbourhoods; it stops early once a round no
+   longer splits any colour class, as later rounds would not either. */
+static int wl_hash_csr(int n, int m, const int *outPtr, const int *outIdx, int rounds, uint64_t *hash) {
+    int *inPtr = calloc((size_t)n + 1, sizeof(int));
+    int *inIdx = malloc((m > 0 ? (size_t)m : 1) * sizeof(int));
+    uint64_t *colours = malloc((n > 0 ? (size_t)n : 1) * sizeof(uint64_t));
+    uint64_t *next = malloc((n > 0 ? (size_t)n : 1) * sizeof(uint64_t));
+    uint64_t *sorted = malloc((n > 0 ? (size_t)n : 1) * sizeof(uint64_t));
+    if (!inPtr || !inIdx || !colours || !next || !sorted) {
+        fprintf(stderr, "Memory allocation error for graph fingerprint\n");
+        free(inPtr);
+        free(inIdx);
+        free(colours);
+        free(next);
+        free(sorted);
+        return -2;
+    }
+
+    for (int e = 0; e < m; e++) inPtr[outIdx[e] + 1]++;
+    for (int v = 0; v < n; v++) inPtr[v + 1] += inPtr[v];
+    for (int v = 0; v < n; v++) {
+        for (int e = outPtr[v]; e < outPtr[v + 1]; e++) {
+            inIdx[inPtr[outIdx[e]]++] = v;
+        }
+    }
+    for (int v = n; v > 0; v--) inPtr[v] = inPtr[v - 1];
+    inPtr[0] = 0;
+
+    for (int v = 0; v < n; v++) {
+        uint64_t outDegree = (uint64_t)(outPtr[v + 1] - outPtr[v]);
+        uint64_t inDegree = (uint64_t)(inPtr[v + 1] - inPtr[v]);
+        colours[v] = mix64(outDegree << 32 | inDegree);
+    }
+    memcpy(sorted, colours, (size_t)n * sizeof(uint64_t));
+    int classes = count_distinct(sorted, n);
+
+    if (rounds > WL_MAX_ROUNDS) rounds = WL_MAX_ROUNDS;
+    for (int round = 0; round < rounds; round++) {
+        for (int v = 0; v < n; v++) {
+            // Sums make the neighbour colours an order-independent multiset
+            uint64_t outSum = 0, inSum = 0;
+            for (int e = outPtr[v]; e < outPtr[v + 1]; e++) outSum += mix64(colours[outIdx[e]]);
+            for (int e = inPtr[v]; e < inPtr[v + 1]; e++) inSum += mix64(colours[inIdx[e]] ^ WL_HASH_TAG);
+            next[v] = mix64(colours[v] * 0x9E3779B97F4A7C15ULL + outSum + (inSum << 17 | inSum >> 47));
+        }
+        uint64_t *swap = colours;
+        colours = next;
+        next = swap;
+
+        memcpy(sorted, colours, (size_t)n * sizeof(uint64_t));
+        int refined = count_distinct(sorted, n);
+        if (refined == classes) break;
+        classes = refined;
+    }
+
+    *hash = csrrgChecksum((const char *)sorted, (size_t)n * sizeof(uint64_t),
+                          WL_HASH_TAG ^ ((uint64_t)n << 32) ^ (uint64_t)m);
+    free(inPtr);
+    free(inIdx);
+    free(colours);
+    free(next);
+    free(sorted);
+    return 0;
+}
+
+int wlSparseGraphHash(const SparseGraph *graph, int rounds, uint64_t *hash) {
+    return wl_hash_csr(graph->n, graph->m, graph->rowPtr, graph->colIdx, rounds, hash);
+}
+
+int wlGraphHash(const AdjacencyMatrix *matrix, int rounds, uint64_t *hash) {
+    int n = matrix->n;
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) m += matrix->matrix[i][j] != 0;
+    }
+    int *rowPtr = malloc(((size_t)n + 1) * sizeof(int));
+    int *colIdx = malloc((m > 0 ? (size_t)m : 1) * sizeof(int));
+    if (!rowPtr || !colIdx) {
+        fprintf(stderr, "Memory allocation error for graph fingerprint\n");
+        free(rowPtr);
+        free(colIdx);
+        return -2;
+    }
+    int e = 0;
+    for (int i = 0; i < n; i++) {
+        rowPtr[i] = e;
+        for (int j = 0; j < n; j++) {
+            if (matrix->matrix[i][j] != 0) colIdx[e++] = j;
+        }
+    }
+    rowPtr[n] = e;
+
+    int status = wl_hash_csr(n, m, rowPtr, colIdx, rounds, hash);
+    free(rowPtr);
+    free(colIdx);
+    return status;
+}
+
+int graphFingerprint(const AdjacencyMatrix *matrix, FingerprintKind kind, uint64_t *hash) {
+    if (kind == FINGERPRINT_ISO) return wlGraphHash(matrix, WL_DEFAULT_ROUNDS, hash);
+    *hash = exactGraphHash(matrix);
+    return 0;
+}
+
+int sparseGraphFingerprint(const SparseGraph *graph, FingerprintKind kind, uint64_t *hash) {
+    if (kind == FINGERPRINT_ISO) return wlSparseGraphHash(graph, WL_DEFAULT_ROUNDS, hash);
+    *hash = exactSparseGraphHash(graph);
+    return 0;
+}
+
+int initFingerprintSet(FingerprintSet *set, size_t expected) {
+    size_t capacity = FINGERPRINT_MIN_SLOTS;
+    while (capacity < expected * 2) capacity <<= 1;
+    set->slots = calloc(capacity, sizeof(*set->slots));
+    if (!set->slots) {
+        fprintf(stderr, "Memory allocation error for fingerprint set\n");
+        return -2;
+    }
+    set->mask = capacity - 1;
+    atomic_init(&set->count, 0);
+    return 0;
+}
+
+int fingerprintSetInsert(FingerprintSet *set, uint64_t hash) {
+    if (hash == 0) hash = 1;  // 0 marks an empty slot
+    size_t slot = (size_t)hash & set->mask;
+    for (size_t probe = 0; probe <= set->mask; probe++, slot = (slot + 1) & set->mask) {
+        uint64_t current = atomic_load_explicit(&set->slots[slot], memory_order_relaxed);
+        if (current == 0) {
+            // Another thread may claim the slot first, with this very hash
+            if (atomic_compare_exchange_strong_explicit(&set->slots[slot], &current, hash,
+                                                        memory_order_relaxed, memory_order_relaxed)) {
+                atomic_fetch_add_explicit(&set->count, 1, memory_order_relaxed);
+                return 1;
+            }
+        }
+        if (current == hash) return 0;
+    }
+    return -1;
+}
+
+void freeFingerprintSet(FingerprintSet *set) {
+    free(set->slots);
+    set->slots = NULL;
+    set->mask = 0;
+}
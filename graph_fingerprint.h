@@ -0,0 +1,47 @@
+#ifndef GRAPH_FINGERPRINT_H
+#define GRAPH_FINGERPRINT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "graph_matrix.h"
+#include "sparse_graph.h"
+
+#define WL_DEFAULT_ROUNDS 3  // Refinement rounds unless the colouring settles earlier
+
+typedef enum FingerprintKind {
+    FINGERPRINT_NONE,
+    FINGERPRINT_EXACT,  // Same adjacency data, vertex order included
+    FINGERPRINT_ISO     // Weisfeiler-Lehman hash, equal for relabelled copies
+} FingerprintKind;
+
+/* 64-bit graph hashes. The exact hash covers every cell of an n x n matrix
+   (or the CSR arrays of a sparse graph). The WL hash colours each vertex by
+   its out- and in-degree, then repeatedly by its own colour and the
+   multisets of its out- and in-neighbours' colours, and hashes the sorted
+   final colours; isomorphic graphs always share it, and different graphs
+   that WL refinement cannot tell apart (e.g. some regular graphs) do too.
+   The WL functions return 0, or -2 on allocation errors. */
+uint64_t exactGraphHash(const AdjacencyMatrix *matrix);
+uint64_t exactSparseGraphHash(const SparseGraph *graph);
+int wlGraphHash(const AdjacencyMatrix *matrix, int rounds, uint64_t *hash);
+int wlSparseGraphHash(const SparseGraph *graph, int rounds, uint64_t *hash);
+int graphFingerprint(const AdjacencyMatrix *matrix, FingerprintKind kind, uint64_t *hash);
+int sparseGraphFingerprint(const SparseGraph *graph, FingerprintKind kind, uint64_t *hash);
+
+/* Fixed-size lock-free set of fingerprints shared by any number of
+   threads: open addressing with linear probing, slots claimed by
+   compare-and-swap. Nothing is ever removed. */
+typedef struct FingerprintSet {
+    _Atomic uint64_t *slots;  // 0 marks an empty slot
+    size_t mask;              // Capacity - 1, capacity is a power of two
+    _Atomic size_t count;
+} FingerprintSet;
+
+// Room for `expected` fingerprints at a load factor of at most 1/2
+int initFingerprintSet(FingerprintSet *set, size_t expected);
+// 1 if the fingerprint was added, 0 if it was already there, -1 if the set is full
+int fingerprintSetInsert(FingerprintSet *set, uint64_t hash);
+void freeFingerprintSet(FingerprintSet *set);
+
+#endif // GRAPH_FINGERPRINT_H
@@ -1,4 +1,5 @@
 #include "graph_generator.h"
+#include "stats.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,26 +7,46 @@
 
 #define MAX_VERTICES 26  // Assume max number of vertices is 26 (A-Z)
 
+void graph_rng_seed(GraphRng *rng, uint64_t seed) {
+    // splitmix64 step, so nearby seeds give unrelated streams
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    rng->state = z ? z : 1;  // xorshift state must never be zero
+}
+
+uint64_t graph_rng_next(GraphRng *rng) {
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return x * 2685821657736338717ULL;
+}
+
+// Returns 1 with the given probability; rng == NULL keeps the old rand() % 2 behaviour
+static int random_bit(GraphRng *rng, double density) {
+    if (!rng) return rand() % 2;
+    return (graph_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0) < density;
+}
+
 AdjacencyMatrix generate_random_graph(int n) {
-    AdjacencyMatrix matrix = {NULL, n};
-    matrix.matrix = malloc(n * sizeof(int *));
+    return generate_random_graph_r(n, 0.5, NULL);
+}
+
+AdjacencyMatrix generate_random_graph_r(int n, double density, GraphRng *rng) {
+    uint64_t phase = statsPhaseBegin();
+    AdjacencyMatrix matrix = createAdjacencyMatrix(n, n);
     if (!matrix.matrix) {
-        fprintf(stderr, "Memory allocation error\n");
         return matrix;
     }
     for (int i = 0; i < n; i++) {
-        matrix.matrix[i] = malloc(n * sizeof(int));
-        if (!matrix.matrix[i]) {
-            fprintf(stderr, "Memory allocation error for row\n");
-            while (i > 0) free(matrix.matrix[--i]);
-            free(matrix.matrix);
-            matrix.matrix = NULL;
-            return matrix;
-        }
         for (int j = 0; j < n; j++) {
-            matrix.matrix[i][j] = rand() % 2; // Random 0 or 1
+            matrix.matrix[i][j] = random_bit(rng, density); // Random 0 or 1
         }
     }
+    statsPhaseEnd(STATS_GENERATE, phase);
     return matrix;
 }
 
@@ -52,25 +73,21 @@ static void trim_whitespace(char *str) {
     memmove(str, start, end - start + 2);  // Move trimmed string to start
 }
 
+static AdjacencyMatrix user_defined_graph(int n, const char *edges);
+
 AdjacencyMatrix generate_user_defined_graph(int n, const char *edges) {
-    AdjacencyMatrix matrix = {NULL, n};
-    matrix.matrix = malloc(n * sizeof(int *));
+    uint64_t phase = statsPhaseBegin();
+    AdjacencyMatrix matrix = user_defined_graph(n, edges);
+    statsPhaseEnd(STATS_GENERATE, phase);
+    return matrix;
+}
+
+static AdjacencyMatrix user_defined_graph(int n, const char *edges) {
+    AdjacencyMatrix matrix = createAdjacencyMatrix(n, n);  // Zero-initialized
     if (!matrix.matrix) {
-        fprintf(stderr, "Memory allocation error\n");
         return matrix;
     }
 
-    for (int i = 0; i < n; i++) {
-        matrix.matrix[i] = calloc(n, sizeof(int));  // Zero-initialized
-        if (!matrix.matrix[i]) {
-            fprintf(stderr, "Memory allocation error for row\n");
-            while (i > 0) free(matrix.matrix[--i]);
-            free(matrix.matrix);
-            matrix.matrix = NULL;
-            return matrix;
-        }
-    }
-
     if (edges && edges[0] != '\0') {
         char *edges_copy = strdup(edges);
         if (!edges_copy) {
@@ -79,11 +96,12 @@ AdjacencyMatrix generate_user_defined_graph(int n, const char *edges) {
             return matrix;
         }
 
-        char *token = strtok(edges_copy, ",");
+        char *saveptr;
+        char *token = strtok_r(edges_copy, ",", &saveptr);
         while (token != NULL) {
             trim_whitespace(token);  // Remove leading/trailing spaces
             if (strlen(token) == 0) {
-                token = strtok(NULL, ",");  // Skip empty tokens
+                token = strtok_r(NULL, ",", &saveptr);  // Skip empty tokens
                 continue;
             }
 
@@ -111,7 +129,7 @@ AdjacencyMatrix generate_user_defined_graph(int n, const char *edges) {
             } else {
                 fprintf(stderr, "Invalid edge format: %s (expected 'X->Y')\n", token);
             }
-            token = strtok(NULL, ",");
+            token = strtok_r(NULL, ",", &saveptr);
         }
         free(edges_copy);
     }
@@ -120,22 +138,24 @@ AdjacencyMatrix generate_user_defined_graph(int n, const char *edges) {
 }
 
 AdjacencyMatrix create_matrix_from_extracted(const char *response, int n) {
-    AdjacencyMatrix matrix = {NULL, n};
-    matrix.matrix = malloc(n * sizeof(int *));
+    return create_matrix_from_extracted_r(response, n, NULL);
+}
+
+static AdjacencyMatrix matrix_from_extracted(const char *response, int n, GraphRng *rng);
+
+AdjacencyMatrix create_matrix_from_extracted_r(const char *response, int n, GraphRng *rng) {
+    uint64_t phase = statsPhaseBegin();
+    AdjacencyMatrix matrix = matrix_from_extracted(response, n, rng);
+    statsPhaseEnd(STATS_RESPONSE_PARSE, phase);
+    return matrix;
+}
+
+static AdjacencyMatrix matrix_from_extracted(const char *response, int n, GraphRng *rng) {
+    AdjacencyMatrix matrix = createAdjacencyMatrix(n, n);  // Zero-initialized
     if (!matrix.matrix) {
-        fprintf(stderr, "Memory allocation error\n");
         return matrix;
     }
-    for (int i = 0; i < n; i++) {
-        matrix.matrix[i] = calloc(n, sizeof(int)); // Zero-initialized
-        if (!matrix.matrix[i]) {
-            fprintf(stderr, "Memory allocation error for row\n");
-            while (i > 0) free(matrix.matrix[--i]);
-            free(matrix.matrix);
-            matrix.matrix = NULL;
-            return matrix;
-        }
-    }
+    STATS_ADD(STATS_BYTES_READ, strlen(response));
 
     const char *matrix_start = strstr(response, ">>>");
     if (!matrix_start) {
@@ -153,13 +173,14 @@ AdjacencyMatrix create_matrix_from_extracted(const char *response, int n) {
     }
 
     int i = 0;
-    char *line = strtok(matrix_copy, "|");
+    char *saveptr;
+    char *line = strtok_r(matrix_copy, "|", &saveptr);
     while (line != NULL && i < n) {
         int j = 0;
         char *num = line;
         while (*num != '\0' && j < n) {
             if (*num == 'F') {
-                matrix.matrix[i][j] = rand() % 2; // Random 0 or 1 for 'F'
+                matrix.matrix[i][j] = random_bit(rng, 0.5); // Random 0 or 1 for 'F'
             } else if (*num == '0' || *num == '1') {
                 matrix.matrix[i][j] = (*num - '0'); // Use specified value
             } else {
@@ -178,7 +199,7 @@ AdjacencyMatrix create_matrix_from_extracted(const char *response, int n) {
             return matrix;
         }
         i++;
-        line = strtok(NULL, "|");
+        line = strtok_r(NULL, "|", &saveptr);
     }
     free(matrix_copy);
 
@@ -1,10 +1,21 @@
 #ifndef GRAPH_GENERATOR_H
 #define GRAPH_GENERATOR_H
 
+#include <stdint.h>
 #include "graph_matrix.h"
 
+// Small per-caller random generator (xorshift64*), so threads don't share rand()
+typedef struct GraphRng {
+    uint64_t state;
+} GraphRng;
+
+void graph_rng_seed(GraphRng *rng, uint64_t seed);
+uint64_t graph_rng_next(GraphRng *rng);
+
 AdjacencyMatrix generate_random_graph(int n);
+AdjacencyMatrix generate_random_graph_r(int n, double density, GraphRng *rng);
 AdjacencyMatrix generate_user_defined_graph(int n, const char *edges);
 AdjacencyMatrix create_matrix_from_extracted(const char *response, int n);
+AdjacencyMatrix create_matrix_from_extracted_r(const char *response, int n, GraphRng *rng);
 
 #endif
\ No newline at end of file
@@ -1,10 +1,116 @@
 #include "graph_matrix.h"
+#include "stats.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Arena used by createAdjacencyMatrix on this thread, NULL = plain malloc
+static _Thread_local MatrixArena *currentArena = NULL;
+
+static size_t matrix_block_size(int rows, int columns) {
+    return (size_t)rows * sizeof(int *) + MATRIX_ALIGNMENT + (size_t)rows * columns * sizeof(int);
+}
+
+// Lays out the row pointers at the start of block and the data after them
+static void layout_matrix(AdjacencyMatrix *matrix, unsigned char *block, int rows, int columns) {
+    uintptr_t data = (uintptr_t)(block + (size_t)rows * sizeof(int *));
+    data = (data + MATRIX_ALIGNMENT - 1) & ~(uintptr_t)(MATRIX_ALIGNMENT - 1);
+    matrix->matrix = (int **)block;
+    for (int i = 0; i < rows; i++) {
+        matrix->matrix[i] = (int *)data + (size_t)i * columns;
+    }
+}
+
+/* Creates a zeroed rows x columns matrix with a single allocation: the row
+   pointer array followed by one cache-line-aligned block of cells. Taken
+   from the thread's arena (see useMatrixArena) when one is set and has room. */
+AdjacencyMatrix createAdjacencyMatrix(int rows, int columns) {
+    AdjacencyMatrix matrix = {NULL, rows, 0};
+    if (rows < 0 || columns < 0) {
+        fprintf(stderr, "Invalid matrix size %d x %d\n", rows, columns);
+        return matrix;
+    }
+    size_t bytes = matrix_block_size(rows, columns);
+
+    if (currentArena) {
+        size_t offset = (currentArena->used + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+        if (offset + bytes <= currentArena->size) {
+            unsigned char *block = currentArena->base + offset;
+            currentArena->used = offset + bytes;
+            memset(block, 0, bytes);
+            layout_matrix(&matrix, block, rows, columns);
+            matrix.fromArena = 1;
+            return matrix;
+        }
+        currentArena->overflow += bytes;
+    }
+
+    unsigned char *block = calloc(1, bytes);
+    if (!block) {
+        fprintf(stderr, "Memory allocation error for %d x %d matrix\n", rows, columns);
+        return matrix;
+    }
+    STATS_ALLOC(bytes);
+    layout_matrix(&matrix, block, rows, columns);
+    return matrix;
+}
+
+int initMatrixArena(MatrixArena *arena, size_t bytes, size_t limit) {
+    arena->base = malloc(bytes);
+    arena->size = arena->base ? bytes : 0;
+    arena->limit = limit > bytes ? limit : bytes;
+    arena->used = 0;
+    arena->overflow = 0;
+    if (!arena->base) {
+        fprintf(stderr, "Memory allocation error for matrix arena\n");
+        return -2;
+    }
+    return 0;
+}
+
+/* Releases every matrix carved from the arena at once. If some requests did
+   not fit since the last reset, the arena grows so they will next time, but
+   never past its limit: larger matrices keep coming from the heap and are
+   freed with their task. The old block is freed first, so growing never
+   holds both. */
+void resetMatrixArena(MatrixArena *arena) {
+    if (arena->overflow > 0 && arena->size < arena->limit) {
+        size_t size = arena->used + arena->overflow + MATRIX_ALIGNMENT;
+        if (size < arena->size * 2) size = arena->size * 2;
+        if (size > arena->limit) size = arena->limit;
+        free(arena->base);
+        arena->base = malloc(size);
+        arena->size = arena->base ? size : 0;
+    }
+    arena->used = 0;
+    arena->overflow = 0;
+}
+
+void freeMatrixArena(MatrixArena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = arena->used = arena->overflow = 0;
+}
+
+// Makes createAdjacencyMatrix on this thread use the arena; returns the previous one
+MatrixArena *useMatrixArena(MatrixArena *arena) {
+    MatrixArena *previous = currentArena;
+    currentArena = arena;
+    return previous;
+}
+
+static AdjacencyMatrix parse_adjacency_matrix(const char *json_response);
+
 AdjacencyMatrix parseAdjacencyMatrix(const char *json_response) {
-    AdjacencyMatrix matrix = {NULL, 0};
+    uint64_t phase = statsPhaseBegin();
+    AdjacencyMatrix matrix = parse_adjacency_matrix(json_response);
+    statsPhaseEnd(STATS_RESPONSE_PARSE, phase);
+    return matrix;
+}
+
+static AdjacencyMatrix parse_adjacency_matrix(const char *json_response) {
+    AdjacencyMatrix matrix = {NULL, 0, 0};
 
     // Find "content" field
     const char *content_start = strstr(json_response, "\"content\": \"");
@@ -54,25 +160,14 @@ AdjacencyMatrix parseAdjacencyMatrix(const char *json_response) {
     matrix_start += strlen(">>>");
 
     // Allocate matrix
-    matrix.n = numRows;
-    matrix.matrix = malloc(numRows * sizeof(int *));
+    matrix = createAdjacencyMatrix(numRows, numRows);
     if (!matrix.matrix) {
         fprintf(stderr, "Błąd alokacji pamięci dla macierzy\n");
         free(content);
         return matrix;
     }
-    for (int i = 0; i < numRows; i++) {
-        matrix.matrix[i] = malloc(numRows * sizeof(int));
-        if (!matrix.matrix[i]) {
-            fprintf(stderr, "Błąd alokacji pamięci dla wiersza\n");
-            while (i > 0) free(matrix.matrix[--i]);
-            free(matrix.matrix);
-            free(content);
-            matrix.matrix = NULL;
-            return matrix;
-        }
-        memset(matrix.matrix[i], 0, numRows * sizeof(int));
-    }
+    STATS_ALLOC(content_length + 1);
+    STATS_ADD(STATS_BYTES_READ, strlen(json_response));
 
     // Parse matrix with '|' as delimiter
     char *matrix_copy = strdup(matrix_start);
@@ -84,7 +179,8 @@ AdjacencyMatrix parseAdjacencyMatrix(const char *json_response) {
     }
 
     int i = 0;
-    char *line = strtok(matrix_copy, "|");
+    char *saveptr;
+    char *line = strtok_r(matrix_copy, "|", &saveptr);
     while (line != NULL && i < numRows) {
         int j = 0;
         char *num = line;
@@ -110,7 +206,7 @@ AdjacencyMatrix parseAdjacencyMatrix(const char *json_response) {
             fprintf(stderr, "Niewłaściwa liczba elementów w wierszu %d (oczekiwano %d, znaleziono %d)\n", i, numRows, j);
         }
         i++;
-        line = strtok(NULL, "|");
+        line = strtok_r(NULL, "|", &saveptr);
     }
     if (i != numRows) {
         fprintf(stderr, "Niezgodna liczba wierszy w danych (oczekiwano %d, znaleziono %d)\n", numRows, i);
@@ -122,42 +218,60 @@ AdjacencyMatrix parseAdjacencyMatrix(const char *json_response) {
 }
 
 void printAdjacencyMatrix(const AdjacencyMatrix *matrix) {
+    printAdjacencyMatrixRowsToFile(stdout, matrix);
+}
+
+void printAdjacencyMatrixRowsToFile(FILE *file, const AdjacencyMatrix *matrix) {
+    uint64_t phase = statsPhaseBegin();
+    long written = 0;
     for (int i = 0; i < matrix->n; i++) {
         for (int j = 0; j < matrix->n; j++) {
-            printf("%d ", matrix->matrix[i][j]);
+            written += fprintf(file, "%d ", matrix->matrix[i][j]);
         }
-        printf("\n");
+        written += fprintf(file, "\n");
     }
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    statsPhaseEnd(STATS_PRINT, phase);
 }
 
 void printAdjacencyMatrixToFile(FILE *file, const AdjacencyMatrix *matrix, int columns) {
+    long written = 0;
     for (int i = 0; i < matrix->n; i++) {
-        fprintf(file, " [");
+        written += fprintf(file, " [");
         for (int j = 0; j < columns; j++) {
-            fprintf(file, "%d.", matrix->matrix[i][j]);
+            written += fprintf(file, "%d.", matrix->matrix[i][j]);
 	    if (j < columns - 1) {
-	        fprintf(file, " ");
+	        written += fprintf(file, " ");
 	    }
         }
-        fprintf(file, "]\n");
+        written += fprintf(file, "]\n");
     }
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
 }
 
 void printConnectionsToFile(FILE *file, const AdjacencyMatrix *matrix) {
+    uint64_t phase = statsPhaseBegin();
+    long written = 0;
+    long edges = 0;
     for (int i = 0; i < matrix->n; i++) {
         for (int j = 0; j < matrix->n; j++) {
             if (matrix->matrix[i][j] == 1) {
-                fprintf(file, "%d - %d\n", i, j);
+                written += fprintf(file, "%d - %d\n", i, j);
+                edges++;
             }
         }
     }
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    STATS_ADD(STATS_EDGES_EMITTED, edges);
+    statsPhaseEnd(STATS_PRINT, phase);
 }
 
 
 
 void freeAdjacencyMatrix(AdjacencyMatrix *matrix) {
-    for (int i = 0; i < matrix->n; i++) {
-        free(matrix->matrix[i]);
+    // Row pointers and cells share one block; arena blocks go with resetMatrixArena
+    if (!matrix->fromArena) {
+        free(matrix->matrix);
     }
-    free(matrix->matrix);
+    matrix->matrix = NULL;  // Callers test for NULL after error paths that already freed
 }
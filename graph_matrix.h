@@ -1,16 +1,37 @@
 #ifndef GRAPH_MATRIX_H
 #define GRAPH_MATRIX_H
 #include <stdio.h>
+#include <stddef.h>
+
+#define MATRIX_ALIGNMENT 64  // Początek danych wyrównany do linii cache
 
 // Struktura reprezentująca macierz sąsiedztwa
 typedef struct AdjacencyMatrix {
     int **matrix;  // Dwuwymiarowa tablica reprezentująca macierz
     int n;         // Liczba wierzchołków
+    int fromArena; // Pamięć należy do MatrixArena, free jej nie zwalnia
 } AdjacencyMatrix;
 
+// Wielokrotnie używany bufor na macierze dla zadań wsadowych
+typedef struct MatrixArena {
+    unsigned char *base;
+    size_t size;
+    size_t limit;     // Arena nie rośnie ponad ten rozmiar
+    size_t used;
+    size_t overflow;  // Bajty, które się nie zmieściły od ostatniego resetu
+} MatrixArena;
+
+// Alokacja: jeden blok z tablicą wskaźników na wiersze i wyzerowanymi danymi
+AdjacencyMatrix createAdjacencyMatrix(int rows, int columns);
+int initMatrixArena(MatrixArena *arena, size_t bytes, size_t limit);
+void resetMatrixArena(MatrixArena *arena);
+void freeMatrixArena(MatrixArena *arena);
+MatrixArena *useMatrixArena(MatrixArena *arena);
+
 // Funkcje do przetwarzania macierzy
 AdjacencyMatrix parseAdjacencyMatrix(const char *json_response);
 void printAdjacencyMatrix(const AdjacencyMatrix *matrix);
+void printAdjacencyMatrixRowsToFile(FILE *file, const AdjacencyMatrix *matrix);
 void printAdjacencyMatrixToFile(FILE *file, const AdjacencyMatrix *matrix, int columns);
 void printConnectionsToFile(FILE *file, const AdjacencyMatrix *matrix);
 void freeAdjacencyMatrix(AdjacencyMatrix *matrix);
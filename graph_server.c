@@ -0,0 +1,900 @@
+#include "graph_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int runGraphServer(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "--serve needs Unix domain sockets, which this platform does not have\n");
+    return -1;
+}
+
+int queryGraphServer(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "--query needs Unix domain sockets, which this platform does not have\n");
+    return -1;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "csrrg.h"
+#include "csrrg_validate.h"
+#include "sparse_graph.h"
+#include "utils.h"
+
+#define SERVER_MAX_REQUEST 4096   // Longest request line accepted
+#define SERVER_READ_SIZE 4096
+#define SERVER_MAX_ARGS 5
+#define SERVER_POLL_MS 200        // How often the event loop checks for shutdown
+#define SERVER_SEND_TIMEOUT_MS 5000  // A client that stops reading its reply is dropped after this
+#define MTX_BANNER "%%MatrixMarket matrix coordinate pattern general\n"
+
+/* One loaded .csrrg file. Never modified after load_graph returns, so any
+   number of workers can read it at once; `refs` keeps it alive while a
+   request uses it after a reload has replaced it. */
+typedef struct ServedGraph {
+    int maxRowNodes;     // Header line 1
+    char *line2;         // Header lines 2 and 3 without the newline, for export
+    char *line3;
+    int vertexTotal;
+    SparseGraph out;     // Edges of all sections, targets of every vertex sorted
+    int *inDegree;
+    int *edgeSrc;        // Edges in file order
+    int *edgeDst;
+    long edgeCount;
+    long *sectionStart;  // sectionCount + 1 offsets into edgeSrc/edgeDst
+    int sectionCount;
+    atomic_int refs;
+} ServedGraph;
+
+typedef struct GraphSlot {
+    char name[64];        // File name without directory and .csrrg
+    const char *path;
+    time_t mtime;         // Of the file version last loaded or tried
+    off_t size;
+    ServedGraph *graph;
+    pthread_mutex_t lock; // Guards graph and the file stamp
+} GraphSlot;
+
+typedef struct Client {
+    int fd;
+    char *input;          // Bytes received and not yet answered
+    size_t length;
+    size_t capacity;
+    struct Client *next;  // In the work queue
+} Client;
+
+typedef struct GraphServer {
+    GraphSlot *slots;
+    int slotCount;
+    int reloadMs;
+    // Readable clients waiting for a worker
+    Client *queueHead;
+    Client *queueTail;
+    int closed;
+    pthread_mutex_t queueLock;
+    pthread_cond_t queueReady;
+    int wake[2];          // Workers hand finished clients back to the event loop here
+} GraphServer;
+
+typedef struct Reply {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Reply;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void request_stop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+static int send_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return -1;
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+// ---- Loading ----
+
+static void free_served_graph(ServedGraph *graph) {
+    if (!graph) return;
+    free(graph->line2);
+    free(graph->line3);
+    freeSparseGraph(&graph->out);
+    free(graph->inDegree);
+    free(graph->edgeSrc);
+    free(graph->edgeDst);
+    free(graph->sectionStart);
+    free(graph);
+}
+
+static void release_graph(ServedGraph *graph) {
+    if (graph && atomic_fetch_sub(&graph->refs, 1) == 1) free_served_graph(graph);
+}
+
+static ServedGraph *acquire_graph(GraphSlot *slot) {
+    pthread_mutex_lock(&slot->lock);
+    ServedGraph *graph = slot->graph;
+    if (graph) atomic_fetch_add(&graph->refs, 1);
+    pthread_mutex_unlock(&slot->lock);
+    return graph;
+}
+
+static void trim_line(char *line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ')) {
+        line[--length] = '\0';
+    }
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Appends the int32 pairs of a section formatted with CSRRG_EDGES_BINARY
+static int append_section_edges(ServedGraph *graph, const CsrrgSection *section, long *capacity) {
+    if (graph->edgeCount + section->edges > INT_MAX) {
+        fprintf(stderr, "Too many edges to serve: more than %d\n", INT_MAX);
+        return -1;
+    }
+    if (graph->edgeCount + section->edges > *capacity) {
+        long newCapacity = *capacity ? *capacity : 1024;
+        while (newCapacity < graph->edgeCount + section->edges) newCapacity *= 2;
+        int *src = realloc(graph->edgeSrc, newCapacity * sizeof(int));
+        if (src) graph->edgeSrc = src;
+        int *dst = src ? realloc(graph->edgeDst, newCapacity * sizeof(int)) : NULL;
+        if (!dst) {
+            fprintf(stderr, "Memory allocation error for served edges\n");
+            return -5;
+        }
+        graph->edgeDst = dst;
+        *capacity = newCapacity;
+    }
+    for (long e = 0; e < section->edges; e++) {
+        graph->edgeSrc[graph->edgeCount] = (int)getInt32LE(section->text + 8 * e);
+        graph->edgeDst[graph->edgeCount] = (int)getInt32LE(section->text + 8 * e + 4);
+        graph->edgeCount++;
+    }
+    graph->sectionStart[++graph->sectionCount] = graph->edgeCount;
+    return 0;
+}
+
+static int read_served_sections(FILE *f, ServedGraph *graph) {
+    int sectionCapacity = 64;
+    graph->sectionStart = malloc((sectionCapacity + 1) * sizeof(long));
+    if (!graph->sectionStart) {
+        fprintf(stderr, "Memory allocation error for section offsets\n");
+        return -2;
+    }
+    graph->sectionStart[0] = 0;
+    CsrrgSection section = {0};
+    section.style = CSRRG_EDGES_BINARY;
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    long edgeCapacity = 0;
+    int status;
+    while ((status = readCsrrgEdgeSection(f, &line, &lineCapacity, &section)) > 0) {
+        if (graph->sectionCount == sectionCapacity) {
+            sectionCapacity *= 2;
+            long *temp = realloc(graph->sectionStart, (sectionCapacity + 1) * sizeof(long));
+            if (!temp) {
+                fprintf(stderr, "Memory allocation error for section offsets\n");
+                free(section.edgeLine);
+                free(section.pointerLine);
+                status = -5;
+                break;
+            }
+            graph->sectionStart = temp;
+        }
+        CsrrgSectionInfo info;
+        status = validateCsrrgSection(&section, graph->sectionCount + 1, graph->vertexTotal, &info);
+        if (status == 0) status = formatCsrrgEdgeSection(&section);
+        free(section.edgeLine);
+        free(section.pointerLine);
+        section.edgeLine = section.pointerLine = NULL;
+        if (status == 0) status = append_section_edges(graph, &section, &edgeCapacity);
+        if (status != 0) break;
+    }
+    freeCsrrgSection(&section);
+    free(line);
+    return status;
+}
+
+/* Reads and validates a whole file; the server only ever serves graphs
+   that passed the same checks as --check. */
+static ServedGraph *load_graph(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", path);
+        return NULL;
+    }
+    CsrrgHeader header;
+    if (readCsrrgHeader(f, &header) != 0) {
+        fclose(f);
+        return NULL;
+    }
+    CsrrgValidation report;
+    ServedGraph *graph = NULL;
+    if (validateCsrrgHeader(&header, &report) == 0) graph = calloc(1, sizeof(ServedGraph));
+    if (!graph) {
+        freeCsrrgHeader(&header);
+        fclose(f);
+        return NULL;
+    }
+    graph->maxRowNodes = header.maxRowNodes;
+    graph->line2 = header.line2;
+    graph->line3 = header.line3;
+    header.line2 = header.line3 = NULL;
+    freeCsrrgHeader(&header);
+    trim_line(graph->line2);
+    trim_line(graph->line3);
+    graph->vertexTotal = report.vertexTotal;
+    atomic_init(&graph->refs, 1);
+
+    int status = read_served_sections(f, graph);
+    fclose(f);
+    if (status == 0) {
+        status = buildSparseGraph(graph->vertexTotal, graph->edgeSrc, graph->edgeDst, (int)graph->edgeCount, &graph->out);
+    }
+    if (status == 0) {
+        graph->inDegree = calloc(graph->vertexTotal > 0 ? graph->vertexTotal : 1, sizeof(int));
+        if (!graph->inDegree) {
+            fprintf(stderr, "Memory allocation error for in-degrees\n");
+            status = -2;
+        }
+    }
+    if (status != 0) {
+        fprintf(stderr, "Could not load %s\n", path);
+        free_served_graph(graph);
+        return NULL;
+    }
+    for (long e = 0; e < graph->edgeCount; e++) graph->inDegree[graph->edgeDst[e]]++;
+    for (int v = 0; v < graph->vertexTotal; v++) {
+        int start = graph->out.rowPtr[v];
+        qsort(graph->out.colIdx + start, graph->out.rowPtr[v + 1] - start, sizeof(int), compare_ints);
+    }
+    return graph;
+}
+
+static int file_stamp(const char *path, time_t *mtime, off_t *size) {
+    struct stat info;
+    if (stat(path, &info) != 0) return -1;
+    *mtime = info.st_mtime;
+    *size = info.st_size;
+    return 0;
+}
+
+/* Loads the slot's file again and swaps it in. The old graph is freed once
+   the last request still using it lets go. */
+static int reload_slot(GraphSlot *slot) {
+    time_t mtime = 0;
+    off_t size = 0;
+    file_stamp(slot->path, &mtime, &size);
+    ServedGraph *graph = load_graph(slot->path);
+    pthread_mutex_lock(&slot->lock);
+    slot->mtime = mtime;
+    slot->size = size;
+    ServedGraph *old = NULL;
+    if (graph) {
+        old = slot->graph;
+        slot->graph = graph;
+    }
+    pthread_mutex_unlock(&slot->lock);
+    release_graph(old);
+    if (!graph) return -1;
+    fprintf(stderr, "Loaded %s: %d vertices, %ld edges, %d sections\n", slot->name,
+            graph->vertexTotal, graph->edgeCount, graph->sectionCount);
+    return 0;
+}
+
+// Polls the files and reloads the ones whose modification time or size changed
+static void *reload_thread(void *arg) {
+    GraphServer *server = arg;
+    int waited = 0;
+    while (!stopRequested) {
+        struct timespec pause = {0, 100 * 1000000L};
+        nanosleep(&pause, NULL);
+        waited += 100;
+        if (waited < server->reloadMs) continue;
+        waited = 0;
+        for (int i = 0; i < server->slotCount; i++) {
+            GraphSlot *slot = &server->slots[i];
+            time_t mtime;
+            off_t size;
+            if (file_stamp(slot->path, &mtime, &size) != 0) continue;
+            pthread_mutex_lock(&slot->lock);
+            int changed = mtime != slot->mtime || size != slot->size;
+            pthread_mutex_unlock(&slot->lock);
+            if (changed) reload_slot(slot);
+        }
+    }
+    return NULL;
+}
+
+// ---- Requests ----
+
+static char *reply_reserve(Reply *reply, size_t needed) {
+    if (reply->length + needed > reply->capacity) {
+        size_t capacity = reply->capacity ? reply->capacity : 4096;
+        while (capacity < reply->length + needed) capacity *= 2;
+        char *temp = realloc(reply->data, capacity);
+        if (!temp) return NULL;
+        reply->data = temp;
+        reply->capacity = capacity;
+    }
+    return reply->data + reply->length;
+}
+
+static void reply_printf(Reply *reply, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    char *out = length >= 0 ? reply_reserve(reply, (size_t)length + 1) : NULL;
+    if (!out) return;
+    va_start(args, format);
+    vsnprintf(out, (size_t)length + 1, format, args);
+    va_end(args);
+    reply->length += length;
+}
+
+static GraphSlot *find_slot(GraphServer *server, const char *name) {
+    for (int i = 0; i < server->slotCount; i++) {
+        if (strcmp(server->slots[i].name, name) == 0) return &server->slots[i];
+    }
+    return NULL;
+}
+
+static int parse_vertex(const ServedGraph *graph, const char *text, int *vertex) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (*end != '\0' || end == text || value < 0 || value >= graph->vertexTotal) return -1;
+    *vertex = (int)value;
+    return 0;
+}
+
+static int has_edge(const ServedGraph *graph, int u, int v) {
+    return bsearch(&v, graph->out.colIdx + graph->out.rowPtr[u],
+                   graph->out.rowPtr[u + 1] - graph->out.rowPtr[u], sizeof(int), compare_ints) != NULL;
+}
+
+/* The graph as a .csrrg file: the original header and, for every section,
+   one group per run of edges with the same source. Converting it gives the
+   same edges in the same order as the original file. */
+static void export_csrrg(FILE *out, const ServedGraph *graph) {
+    fprintf(out, "%d\n%s\n%s\n", graph->maxRowNodes, graph->line2, graph->line3);
+    for (int s = 0; s < graph->sectionCount; s++) {
+        long start = graph->sectionStart[s], end = graph->sectionStart[s + 1];
+        if (start == end) {
+            if (graph->vertexTotal > 0) fprintf(out, "0\n0\n");  // A lone vertex, no edges
+            continue;
+        }
+        int tokens = 0;
+        for (long e = start; e < end; e++) {
+            if (e == start || graph->edgeSrc[e] != graph->edgeSrc[e - 1]) {
+                fprintf(out, tokens++ ? ";%d" : "%d", graph->edgeSrc[e]);
+            }
+            fprintf(out, ";%d", graph->edgeDst[e]);
+            tokens++;
+        }
+        fprintf(out, "\n0");
+        tokens = 0;
+        for (long e = start; e < end; e++) {
+            tokens += (e == start || graph->edgeSrc[e] != graph->edgeSrc[e - 1]) ? 2 : 1;
+            if (e + 1 == end || graph->edgeSrc[e + 1] != graph->edgeSrc[e]) fprintf(out, ";%d", tokens);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+static void export_edges(FILE *out, const ServedGraph *graph, int base, const char *separator) {
+    char line[48];
+    for (long e = 0; e < graph->edgeCount; e++) {
+        char *end = formatInt(line, (long long)graph->edgeSrc[e] + base);
+        end = stpcpy(end, separator);
+        end = formatInt(end, (long long)graph->edgeDst[e] + base);
+        *end++ = '\n';
+        fwrite(line, 1, end - line, out);
+    }
+}
+
+static int export_graph(Reply *reply, const ServedGraph *graph, const char *format) {
+    char *data = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream(&data, &length);
+    if (!out) return -2;
+    if (strcmp(format, "csrrg") == 0) {
+        export_csrrg(out, graph);
+    } else if (strcmp(format, "edges") == 0) {
+        export_edges(out, graph, 0, " - ");
+    } else if (strcmp(format, "mtx") == 0) {
+        fprintf(out, "%s%d %d %ld\n", MTX_BANNER, graph->vertexTotal, graph->vertexTotal, graph->edgeCount);
+        export_edges(out, graph, 1, " ");
+    } else {
+        fclose(out);
+        free(data);
+        reply_printf(reply, "ERR unknown export format %s (use csrrg, edges or mtx)\n", format);
+        return 0;
+    }
+    int failed = fclose(out) != 0;
+    char *payload = failed ? NULL : reply_reserve(reply, length + 32);
+    if (payload) {
+        reply_printf(reply, "OK %zu\n", length);
+        memcpy(reply_reserve(reply, length), data, length);
+        reply->length += length;
+    }
+    free(data);
+    return payload ? 0 : -2;
+}
+
+static void answer_graph_request(Reply *reply, const ServedGraph *graph, char **args, int count) {
+    const char *command = args[0];
+    int u, v;
+    if (strcmp(command, "neighbors") == 0 && count == 3) {
+        if (parse_vertex(graph, args[2], &v) != 0) {
+            reply_printf(reply, "ERR vertex out of range [0, %d)\n", graph->vertexTotal);
+            return;
+        }
+        int start = graph->out.rowPtr[v], end = graph->out.rowPtr[v + 1];
+        reply_printf(reply, "OK %d\n", end - start);
+        for (int k = start; k < end; k++) {
+            char *out = reply_reserve(reply, 16);
+            if (!out) return;
+            if (k > start) *out++ = ' ';
+            reply->length = formatInt(out, graph->out.colIdx[k]) - reply->data;
+        }
+        reply_printf(reply, "\n");
+    } else if (strcmp(command, "degree") == 0 && count == 3) {
+        if (parse_vertex(graph, args[2], &v) != 0) {
+            reply_printf(reply, "ERR vertex out of range [0, %d)\n", graph->vertexTotal);
+            return;
+        }
+        reply_printf(reply, "OK %d %d\n", graph->out.rowPtr[v + 1] - graph->out.rowPtr[v], graph->inDegree[v]);
+    } else if (strcmp(command, "edge") == 0 && count == 4) {
+        if (parse_vertex(graph, args[2], &u) != 0 || parse_vertex(graph, args[3], &v) != 0) {
+            reply_printf(reply, "ERR vertex out of range [0, %d)\n", graph->vertexTotal);
+            return;
+        }
+        reply_printf(reply, "OK %d\n", has_edge(graph, u, v));
+    } else if (strcmp(command, "section") == 0 && count == 3) {
+        char *end;
+        long k = strtol(args[2], &end, 10);
+        if (*end != '\0' || k < 1 || k > graph->sectionCount) {
+            reply_printf(reply, "ERR section out of range [1, %d]\n", graph->sectionCount);
+            return;
+        }
+        long start = graph->sectionStart[k - 1], stop = graph->sectionStart[k];
+        reply_printf(reply, "OK %ld\n", stop - start);
+        for (long e = start; e < stop; e++) {
+            char *out = reply_reserve(reply, 32);
+            if (!out) return;
+            out = formatInt(out, graph->edgeSrc[e]);
+            memcpy(out, " - ", 3);
+            out = formatInt(out + 3, graph->edgeDst[e]);
+            *out++ = '\n';
+            reply->length = out - reply->data;
+        }
+    } else if (strcmp(command, "export") == 0 && count == 3) {
+        if (export_graph(reply, graph, args[2]) != 0) reply_printf(reply, "ERR out of memory\n");
+    } else {
+        reply_printf(reply, "ERR unknown request or wrong number of arguments\n");
+    }
+}
+
+// Answers one request line; returns 1 when the client asked to close
+static int answer_request(GraphServer *server, char *line, Reply *reply) {
+    char *args[SERVER_MAX_ARGS + 1];
+    int count = 0;
+    char *saveptr;
+    for (char *token = strtok_r(line, " \t\r", &saveptr); token && count <= SERVER_MAX_ARGS;
+         token = strtok_r(NULL, " \t\r", &saveptr)) {
+        args[count++] = token;
+    }
+    if (count == 0) return 0;
+    if (strcmp(args[0], "quit") == 0) return 1;
+    if (strcmp(args[0], "list") == 0) {
+        reply_printf(reply, "OK %d\n", server->slotCount);
+        for (int i = 0; i < server->slotCount; i++) {
+            ServedGraph *graph = acquire_graph(&server->slots[i]);
+            reply_printf(reply, "%s %d %ld %d\n", server->slots[i].name, graph->vertexTotal,
+                         graph->edgeCount, graph->sectionCount);
+            release_graph(graph);
+        }
+        return 0;
+    }
+    if (count < 2) {
+        reply_printf(reply, "ERR unknown request or missing graph name\n");
+        return 0;
+    }
+    GraphSlot *slot = find_slot(server, args[1]);
+    if (!slot) {
+        reply_printf(reply, "ERR no graph named %s\n", args[1]);
+        return 0;
+    }
+    if (strcmp(args[0], "reload") == 0 && count == 2) {
+        if (reload_slot(slot) != 0) {
+            reply_printf(reply, "ERR reload failed, still serving the previous version\n");
+            return 0;
+        }
+        ServedGraph *graph = acquire_graph(slot);
+        reply_printf(reply, "OK %d %ld\n", graph->vertexTotal, graph->edgeCount);
+        release_graph(graph);
+        return 0;
+    }
+    ServedGraph *graph = acquire_graph(slot);
+    answer_graph_request(reply, graph, args, count);
+    release_graph(graph);
+    return 0;
+}
+
+// ---- Connections ----
+
+static void close_client(Client *client) {
+    close(client->fd);
+    free(client->input);
+    free(client);
+}
+
+/* Reads what the client sent and answers every complete line. Returns 0
+   when the client stays connected, -1 when it should be closed. */
+static int serve_client(GraphServer *server, Client *client, Reply *reply) {
+    if (client->capacity - client->length < SERVER_READ_SIZE) {
+        size_t capacity = client->capacity ? client->capacity * 2 : 2 * SERVER_READ_SIZE;
+        char *temp = realloc(client->input, capacity);
+        if (!temp) return -1;
+        client->input = temp;
+        client->capacity = capacity;
+    }
+    ssize_t got = recv(client->fd, client->input + client->length, SERVER_READ_SIZE, 0);
+    if (got < 0 && (errno == EINTR || errno == EAGAIN)) return 0;
+    int closing = got <= 0;
+    if (got > 0) client->length += (size_t)got;
+    // A last request without a newline is answered when the client stops sending
+    if (closing && client->length > 0) client->input[client->length++] = '\n';
+
+    size_t start = 0;
+    char *newline;
+    while ((newline = memchr(client->input + start, '\n', client->length - start)) != NULL) {
+        *newline = '\0';
+        reply->length = 0;
+        int quit = answer_request(server, client->input + start, reply);
+        start = newline + 1 - client->input;
+        if (quit) return -1;
+        if (reply->length > 0 && send_all(client->fd, reply->data, reply->length) != 0) return -1;
+    }
+    client->length -= start;
+    memmove(client->input, client->input + start, client->length);
+    if (client->length > SERVER_MAX_REQUEST) {
+        const char *error = "ERR request too long\n";
+        send_all(client->fd, error, strlen(error));
+        return -1;
+    }
+    return closing ? -1 : 0;
+}
+
+static void *worker_thread(void *arg) {
+    GraphServer *server = arg;
+    Reply reply = {0};
+    while (1) {
+        pthread_mutex_lock(&server->queueLock);
+        while (!server->queueHead && !server->closed) pthread_cond_wait(&server->queueReady, &server->queueLock);
+        Client *client = server->queueHead;
+        if (client) {
+            server->queueHead = client->next;
+            if (!server->queueHead) server->queueTail = NULL;
+        }
+        pthread_mutex_unlock(&server->queueLock);
+        if (!client) break;
+
+        if (serve_client(server, client, &reply) != 0) {
+            close_client(client);
+        } else if (write(server->wake[1], &client, sizeof(client)) != sizeof(client)) {
+            close_client(client);
+        }
+    }
+    free(reply.data);
+    return NULL;
+}
+
+static void queue_client(GraphServer *server, Client *client) {
+    client->next = NULL;
+    pthread_mutex_lock(&server->queueLock);
+    if (server->queueTail) {
+        server->queueTail->next = client;
+    } else {
+        server->queueHead = client;
+    }
+    server->queueTail = client;
+    pthread_cond_signal(&server->queueReady);
+    pthread_mutex_unlock(&server->queueLock);
+}
+
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        fprintf(stderr, "Error creating socket\n");
+        return -1;
+    }
+    unlink(path);  // Left over from a server that did not shut down cleanly
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 128) != 0) {
+        fprintf(stderr, "Error binding to %s\n", path);
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+/* Event loop: polls the listener and every idle client; a client with data
+   goes to the worker queue and leaves the poll set until a worker hands it
+   back through the wake pipe, so one connection is only served by one
+   worker at a time while any number of connections wait cheaply. */
+static void run_event_loop(GraphServer *server, int listener) {
+    Client **idle = NULL;
+    struct pollfd *fds = NULL;
+    int idleCount = 0, capacity = 0;
+    while (!stopRequested) {
+        if (idleCount + 2 > capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            Client **moreIdle = realloc(idle, capacity * sizeof(Client *));
+            if (moreIdle) idle = moreIdle;
+            struct pollfd *moreFds = moreIdle ? realloc(fds, capacity * sizeof(struct pollfd)) : NULL;
+            if (!moreFds) {
+                fprintf(stderr, "Memory allocation error for client list\n");
+                break;
+            }
+            fds = moreFds;
+        }
+        fds[0].fd = listener;
+        fds[1].fd = server->wake[0];
+        for (int i = 0; i < idleCount; i++) fds[i + 2].fd = idle[i]->fd;
+        for (int i = 0; i < idleCount + 2; i++) {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        if (poll(fds, idleCount + 2, SERVER_POLL_MS) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "poll failed: %s\n", strerror(errno));
+            break;
+        }
+
+        // Readable clients go to the workers; the rest stay in the poll set
+        int kept = 0;
+        for (int i = 0; i < idleCount; i++) {
+            if (fds[i + 2].revents) {
+                queue_client(server, idle[i]);
+            } else {
+                idle[kept++] = idle[i];
+            }
+        }
+        idleCount = kept;
+        if (fds[1].revents & POLLIN) {
+            Client *returned;
+            while (idleCount < capacity && read(server->wake[0], &returned, sizeof(returned)) == sizeof(returned)) {
+                idle[idleCount++] = returned;
+            }
+        }
+        if ((fds[0].revents & POLLIN) && idleCount < capacity) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0) {
+                // Otherwise a client that never reads a large export holds a worker in send() for good
+                struct timeval timeout = {SERVER_SEND_TIMEOUT_MS / 1000, SERVER_SEND_TIMEOUT_MS % 1000 * 1000};
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            }
+            Client *client = fd >= 0 ? calloc(1, sizeof(Client)) : NULL;
+            if (client) {
+                client->fd = fd;
+                idle[idleCount++] = client;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    for (int i = 0; i < idleCount; i++) close_client(idle[i]);
+    free(idle);
+    free(fds);
+}
+
+static int parse_server_options(int argc, char **argv, int *threads, int *reloadMs, int *first) {
+    *threads = GRAPH_SERVER_THREADS;
+    *reloadMs = GRAPH_SERVER_RELOAD_MS;
+    int i = 3;
+    for (; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            *threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--reload-ms") == 0) {
+            *reloadMs = atoi(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+    *first = i;
+    return *threads > 0 && *reloadMs > 0 && i < argc ? 0 : -1;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+int runGraphServer(int argc, char **argv) {
+    int threads, reloadMs, first;
+    if (argc < 4 || parse_server_options(argc, argv, &threads, &reloadMs, &first) != 0) {
+        fprintf(stderr, "Usage: --serve SOCKET [--threads N] [--reload-ms MS] file.csrrg [file.csrrg ...]\n");
+        return -1;
+    }
+    GraphServer server;
+    memset(&server, 0, sizeof(server));
+    server.slotCount = argc - first;
+    server.reloadMs = reloadMs;
+    server.slots = calloc(server.slotCount, sizeof(GraphSlot));
+    if (!server.slots) {
+        fprintf(stderr, "Memory allocation error for graph slots\n");
+        return -2;
+    }
+    int status = 0;
+    int loaded = 0;
+    for (; loaded < server.slotCount; loaded++) {
+        GraphSlot *slot = &server.slots[loaded];
+        slot->path = argv[first + loaded];
+        snprintf(slot->name, sizeof(slot->name), "%s", base_name(slot->path));
+        char *extension = strstr(slot->name, ".csrrg");
+        if (extension && extension[6] == '\0') *extension = '\0';
+        pthread_mutex_init(&slot->lock, NULL);
+        if (find_slot(&server, slot->name) != slot) {
+            fprintf(stderr, "Two graphs named %s\n", slot->name);
+            status = -1;
+        } else if (reload_slot(slot) != 0) {
+            status = -1;
+        }
+        if (status != 0) {
+            pthread_mutex_destroy(&slot->lock);
+            break;
+        }
+    }
+
+    int listener = status == 0 ? open_listener(argv[2]) : -1;
+    if (status == 0 && listener < 0) status = -3;
+    if (status == 0 && (pipe(server.wake) != 0 || fcntl(server.wake[0], F_SETFL, O_NONBLOCK) != 0)) {
+        fprintf(stderr, "Error creating wake pipe\n");
+        close(listener);
+        status = -1;
+    }
+    if (status != 0) {
+        for (int i = 0; i < loaded; i++) {
+            release_graph(server.slots[i].graph);
+            pthread_mutex_destroy(&server.slots[i].lock);
+        }
+        free(server.slots);
+        return status;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+    pthread_mutex_init(&server.queueLock, NULL);
+    pthread_cond_init(&server.queueReady, NULL);
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    int started = 0;
+    while (workers && started < threads && pthread_create(&workers[started], NULL, worker_thread, &server) == 0) {
+        started++;
+    }
+    pthread_t reloader;
+    int reloading = pthread_create(&reloader, NULL, reload_thread, &server) == 0;
+    if (started == 0) {
+        fprintf(stderr, "Error creating server threads\n");
+        status = -1;
+    } else {
+        printf("Serving %d graph(s) on %s with %d worker(s)\n", server.slotCount, argv[2], started);
+        fflush(stdout);
+        run_event_loop(&server, listener);
+    }
+
+    stopRequested = 1;
+    pthread_mutex_lock(&server.queueLock);
+    server.closed = 1;
+    pthread_cond_broadcast(&server.queueReady);
+    pthread_mutex_unlock(&server.queueLock);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    if (reloading) pthread_join(reloader, NULL);
+    free(workers);
+
+    // Clients the workers handed back after the event loop stopped, or never served
+    for (Client *client = server.queueHead, *next; client; client = next) {
+        next = client->next;
+        close_client(client);
+    }
+    close(server.wake[1]);
+    Client *returned;
+    while (read(server.wake[0], &returned, sizeof(returned)) == sizeof(returned)) close_client(returned);
+    close(server.wake[0]);
+    close(listener);
+    unlink(argv[2]);
+    for (int i = 0; i < server.slotCount; i++) {
+        release_graph(server.slots[i].graph);
+        pthread_mutex_destroy(&server.slots[i].lock);
+    }
+    free(server.slots);
+    pthread_mutex_destroy(&server.queueLock);
+    pthread_cond_destroy(&server.queueReady);
+    return status;
+}
+
+int queryGraphServer(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: --query SOCKET request...\n");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(argv[2]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", argv[2]);
+        return -1;
+    }
+    strcpy(addr.sun_path, argv[2]);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error connecting to %s\n", argv[2]);
+        if (fd >= 0) close(fd);
+        return -4;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    Reply request = {0};
+    for (int i = 3; i < argc; i++) reply_printf(&request, i > 3 ? " %s" : "%s", argv[i]);
+    reply_printf(&request, "\n");
+    int status = request.data && send_all(fd, request.data, request.length) == 0 ? 0 : -3;
+    free(request.data);
+    shutdown(fd, SHUT_WR);  // The server answers and closes once it sees the end
+
+    char buffer[SERVER_READ_SIZE];
+    ssize_t got;
+    int first = 1;
+    while (status == 0 && (got = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        if (first && (got < 2 || strncmp(buffer, "OK", 2) != 0)) status = -1;
+        first = 0;
+        fwrite(buffer, 1, got, stdout);
+    }
+    if (status == -1) {
+        while ((got = recv(fd, buffer, sizeof(buffer), 0)) > 0) fwrite(buffer, 1, got, stdout);
+    }
+    close(fd);
+    return first ? -3 : status;
+}
+
+#endif // _WIN32
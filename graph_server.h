@@ -0,0 +1,31 @@
+#ifndef GRAPH_SERVER_H
+#define GRAPH_SERVER_H
+
+#define GRAPH_SERVER_THREADS 4       // Request workers unless --threads is given
+#define GRAPH_SERVER_RELOAD_MS 1000  // How often the graph files are checked for changes
+
+/* Query server for .csrrg graphs. Every file is loaded once into an
+   immutable in-memory graph (the edge sections as CSR adjacency) that all
+   worker threads read without locking; a graph whose file changes is
+   loaded again and swapped in, while requests already running keep the
+   old copy until they finish.
+
+   Clients connect to a Unix domain socket and send one request per line:
+
+     list                          OK <graphs>, then "name vertices edges sections" lines
+     neighbors <graph> <v>         OK <count>, then the sorted targets of v on one line
+     degree <graph> <v>            OK <out> <in>
+     edge <graph> <u> <v>          OK 1 or OK 0
+     section <graph> <k>           OK <edges>, then "src - dest" lines of section k (1-based)
+     export <graph> <csrrg|edges|mtx>  OK <bytes>, then the graph in that format
+     reload <graph>                OK <vertices> <edges>
+     quit                          Closes the connection
+
+   Errors are answered with "ERR <message>". */
+
+// graph_gen --serve SOCKET [--threads N] file.csrrg...
+int runGraphServer(int argc, char **argv);
+// graph_gen --query SOCKET request...: sends one request and prints the answer
+int queryGraphServer(int argc, char **argv);
+
+#endif // GRAPH_SERVER_H
@@ -0,0 +1,193 @@
+#include "llm_batch.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSWER_PREFIX_TOKENS 12  // "k)Vertices=n>>>" and the separator
+
+int llmBatchSize(int n, int maxTokens, int limit) {
+    if (n <= 0 || limit <= 1) return 1;
+    long perAnswer = (long)n * n + n + ANSWER_PREFIX_TOKENS;
+    long fits = (long)maxTokens * 3 / 4 / perAnswer;
+    if (fits < 1) return 1;
+    return fits < limit ? (int)fits : limit;
+}
+
+// Characters an answer is made of; anything else (quotes, "\n" escapes, spaces) ends it
+static int answer_char(char c) {
+    return isalnum((unsigned char)c) || c == '=' || c == '>' || c == '|';
+}
+
+int splitLlmBatchAnswers(const char *response, int count, char **answers) {
+    for (int i = 0; i < count; i++) answers[i] = NULL;
+
+    const char *start = strstr(response, "\"content\": \"");
+    if (start) {
+        start += strlen("\"content\": \"");
+    } else if ((start = strstr(response, "\"content\":\"")) != NULL) {
+        start += strlen("\"content\":\"");
+    } else {
+        fprintf(stderr, "No content in batched response\n");
+        return 0;
+    }
+    const char *end = strchr(start, '"');
+    if (!end) end = start + strlen(start);
+
+    char *content = malloc(end - start + 1);
+    if (!content) {
+        fprintf(stderr, "Memory allocation error for batched response\n");
+        return -2;
+    }
+    memcpy(content, start, end - start);
+    content[end - start] = '\0';
+
+    int found = 0;
+    int position = 0;
+    char *segment = content;
+    while (segment) {
+        char *separator = strstr(segment, LLM_BATCH_SEPARATOR);
+        if (separator) *separator = '\0';
+
+        char *vertices = strstr(segment, "Vertices=");
+        if (vertices) {
+            // "k)" before the answer, possibly after an escaped newline or spaces
+            int index = position;
+            const char *p = vertices;
+            while (p > segment && p[-1] == ' ') p--;
+            if (p > segment && p[-1] == ')') {
+                const char *digits = --p;
+                while (digits > segment && isdigit((unsigned char)digits[-1])) digits--;
+                if (digits < p) {
+                    int number = atoi(digits);
+                    if (number >= 1 && number <= count && !answers[number - 1]) index = number - 1;
+                }
+            }
+            size_t length = 0;
+            while (answer_char(vertices[length])) length++;
+            if (index < count && !answers[index]) {
+                answers[index] = malloc(length + 1);
+                if (!answers[index]) {
+                    fprintf(stderr, "Memory allocation error for batched answer\n");
+                    for (int i = 0; i < count; i++) {
+                        free(answers[i]);
+                        answers[i] = NULL;
+                    }
+                    free(content);
+                    return -2;
+                }
+                memcpy(answers[index], vertices, length);
+                answers[index][length] = '\0';
+                found++;
+            }
+            position++;
+        }
+        segment = separator ? separator + strlen(LLM_BATCH_SEPARATOR) : NULL;
+    }
+    free(content);
+    return found;
+}
+
+/* Vertex count of a well-formed answer: "Vertices=n>>>" and n rows of n
+   cells separated by '|'. Returns -1 for anything else. */
+static int answer_vertices(const char *answer, int mode) {
+    const char *cells = mode == 0 ? "01F" : "01X";
+    int n = atoi(answer + strlen("Vertices="));
+    const char *row = strstr(answer, ">>>");
+    if (n <= 0 || !row) return -1;
+    row += strlen(">>>");
+
+    int rows = 0;
+    while (1) {
+        int length = 0;
+        while (row[length] && row[length] != '|') {
+            if (!strchr(cells, row[length])) return -1;
+            length++;
+        }
+        if (length != n) return -1;
+        rows++;
+        if (row[length] != '|') break;
+        row += length + 1;
+    }
+    return rows == n ? n : -1;
+}
+
+AdjacencyMatrix parseLlmBatchAnswer(const char *answer, int mode, int n, GraphRng *rng) {
+    AdjacencyMatrix matrix = {NULL, 0, 0};
+    int found = answer_vertices(answer, mode);
+    if (found < 0 || (n > 0 && found != n)) {
+        fprintf(stderr, "Malformed answer in batched response\n");
+        return matrix;
+    }
+    if (mode == 0) {
+        return create_matrix_from_extracted_r(answer, found, rng);
+    }
+
+    // parseAdjacencyMatrix reads the answer from a "content" field
+    static const char field[] = "\"content\": \"";
+    size_t length = strlen(answer);
+    char *wrapped = malloc(sizeof(field) + length + 1);
+    if (!wrapped) {
+        fprintf(stderr, "Memory allocation error for batched answer\n");
+        return matrix;
+    }
+    memcpy(wrapped, field, sizeof(field) - 1);
+    memcpy(wrapped + sizeof(field) - 1, answer, length);
+    wrapped[sizeof(field) - 1 + length] = '"';
+    wrapped[sizeof(field) + length] = '\0';
+    matrix = parseAdjacencyMatrix(wrapped);
+    free(wrapped);
+    return matrix;
+}
+
+// One prompt, one request: the path main.c and batch jobs take without batching
+static AdjacencyMatrix generate_single(CURL *curl, const char *prompt, int mode, int n, GraphRng *rng,
+                                       int *requests) {
+    AdjacencyMatrix matrix = {NULL, 0, 0};
+    char *response = send_request(curl, prompt, mode);
+    (*requests)++;
+    if (!response) {
+        fprintf(stderr, "API communication error\n");
+        return matrix;
+    }
+    matrix = mode == 0 ? create_matrix_from_extracted_r(response, n, rng) : parseAdjacencyMatrix(response);
+    free(response);
+    return matrix;
+}
+
+int generateLlmBatch(CURL *curl, const char *const *prompts, int count, int mode, int n,
+                     int maxTokens, GraphRng *rng, AdjacencyMatrix *graphs, int *requests) {
+    int size = llmBatchSize(n, maxTokens, LLM_BATCH_LIMIT);
+    char *answers[LLM_BATCH_LIMIT];
+    int produced = 0;
+
+    for (int first = 0; first < count; first += size) {
+        int chunk = count - first < size ? count - first : size;
+        memset(graphs + first, 0, chunk * sizeof(AdjacencyMatrix));
+
+        if (chunk > 1) {
+            char *response = send_batch_request(curl, prompts + first, chunk, mode, maxTokens);
+            (*requests)++;
+            if (!response) {
+                fprintf(stderr, "API communication error\n");
+            } else if (splitLlmBatchAnswers(response, chunk, answers) >= 0) {
+                for (int i = 0; i < chunk; i++) {
+                    if (answers[i]) {
+                        graphs[first + i] = parseLlmBatchAnswer(answers[i], mode, n, rng);
+                        free(answers[i]);
+                    }
+                }
+            }
+            free(response);
+        }
+        // Whatever the batch did not deliver is asked for on its own
+        for (int i = 0; i < chunk; i++) {
+            if (graphs[first + i].matrix == NULL) {
+                graphs[first + i] = generate_single(curl, prompts[first + i], mode, n, rng, requests);
+            }
+            produced += graphs[first + i].matrix != NULL;
+        }
+    }
+    return produced;
+}
@@ -0,0 +1,35 @@
+#ifndef LLM_BATCH_H
+#define LLM_BATCH_H
+
+#include "api_comm.h"
+#include "graph_generator.h"
+#include "graph_matrix.h"
+
+#define LLM_BATCH_LIMIT 32         // Most prompts packed into one request
+#define LLM_BATCH_MAX_TOKENS 2048  // Default max_tokens of a batched request
+
+/* Number of n-vertex answers that fit in max_tokens, at most limit. An
+   answer costs about one token per cell plus its row separators and the
+   "k)Vertices=n>>>" prefix; a quarter of max_tokens is kept in reserve. */
+int llmBatchSize(int n, int maxTokens, int limit);
+
+/* Splits the content of a batched response into `count` answers. Each is a
+   malloc'd "Vertices=n>>>..." string, placed by its "k)" number or else by
+   position; answers[i] stays NULL for a missing one. Returns how many were
+   found, or -2 on allocation errors. */
+int splitLlmBatchAnswers(const char *response, int count, char **answers);
+
+/* Parses one answer with parseAdjacencyMatrix (modes 1 and 2) or
+   create_matrix_from_extracted_r (mode 0). The answer must have exactly n
+   rows of n cells (n <= 0 takes n from the answer); otherwise, like on any
+   parse error, .matrix is NULL. */
+AdjacencyMatrix parseLlmBatchAnswer(const char *answer, int mode, int n, GraphRng *rng);
+
+/* Gets one graph per prompt, all in the same mode, with as few requests as
+   max_tokens allows. Prompts whose answer is missing or does not parse are
+   sent again on their own. graphs[i].matrix is NULL where that failed too.
+   Adds the requests made to *requests and returns the graphs obtained. */
+int generateLlmBatch(CURL *curl, const char *const *prompts, int count, int mode, int n,
+                     int maxTokens, GraphRng *rng, AdjacencyMatrix *graphs, int *requests);
+
+#endif // LLM_BATCH_H
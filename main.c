@@ -6,11 +6,58 @@
 #include "graph_matrix.h"
 #include "utils.h"
 #include "csrrg.h"
+#include "batch_jobs.h"
+#include "csrrg_output.h"
+#include "csrrg_validate.h"
+#include "graph_server.h"
+#include "mutable_graph.h"
+#include "csrrg_extract.h"
+#include "csrrg_stats.h"
+#include "stats.h"
 
 #define MAX_INPUT 512
 
+static void print_stats(void) {
+    statsPrint(stderr, statsEnabled == 2);
+}
+
 int main(int argc, char **argv) {
-    if (argc == 2 && strcmp(argv[1] + strlen(argv[1]) - 6, ".csrrg") == 0) {
+    // --stats / --stats=json, --graph-stats[=json], --validate and --format= may appear anywhere; drop them before dispatching
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--validate") == 0) {
+            csrrgValidateInput = 1;
+        } else if (strcmp(argv[i], "--graph-stats") == 0 || strcmp(argv[i], "--graph-stats=json") == 0) {
+            // Statistics of every converted graph, see csrrg_stats.c
+            csrrgStatsMode = argv[i][13] == '=' ? 2 : 1;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            if (parseCsrrgOutputFormat(argv[i] + 9, &csrrgOutputFormat) != 0) return 1;
+        } else if (!statsParseOption(argv[i])) {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = NULL;
+    if (statsEnabled) atexit(print_stats);
+
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        // Structural validation only, see csrrg_validate.c
+        return checkCsrrgFiles(argc - 2, argv + 2);
+    } else if (argc > 1 && strcmp(argv[1], "--extract") == 0) {
+        // Rows or an induced subgraph as a new graph, see csrrg_extract.c
+        return extractCsrrgFile(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--update") == 0) {
+        // Edge changes with in-place re-export, see mutable_graph.c
+        return updateCsrrgFile(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        // Resident graphs queried over a Unix socket, see graph_server.c
+        return runGraphServer(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--query") == 0) {
+        return queryGraphServer(argc, argv);
+    } else if (argc > 1 && strncmp(argv[1], "--", 2) == 0) {
+        // Scripted generation, see batch_jobs.c
+        return runBatchCommand(argc, argv);
+    } else if (argc == 2 && strcmp(argv[1] + strlen(argv[1]) - 6, ".csrrg") == 0) {
         return processCsrrgFile(argv[1]);
     } else if (argc == 2) {
         printf("Invalid file format, use .csrrg to convert it to .txt");
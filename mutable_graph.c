@@ -0,0 +1,879 @@
+#include "mutable_graph.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "csrrg.h"
+#include "stats.h"
+#include "utils.h"
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_updates(const void *a, const void *b) {
+    const EdgeUpdate *x = a, *y = b;
+    if (x->src != y->src) return x->src < y->src ? -1 : 1;
+    if (x->dst != y->dst) return x->dst < y->dst ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+// Targets may go up to the larger of the row count and the dense width
+static int target_limit(const MutableGraph *graph) {
+    return graph->base.n > graph->columns ? graph->base.n : graph->columns;
+}
+
+int initMutableGraph(MutableGraph *graph, SparseGraph *base, int columns) {
+    memset(graph, 0, sizeof(*graph));
+    graph->base = *base;
+    graph->columns = columns;
+    graph->compactAt = MUTABLE_MIN_COMPACT;
+    graph->logSorted = 1;
+    memset(base, 0, sizeof(*base));
+
+    SparseGraph *g = &graph->base;
+    int m = 0;
+    for (int i = 0; i < g->n; i++) {
+        int start = g->rowPtr[i], end = g->rowPtr[i + 1];
+        qsort(g->colIdx + start, end - start, sizeof(int), compare_ints);
+        g->rowPtr[i] = m;
+        for (int k = start; k < end; k++) {
+            if (k == start || g->colIdx[k] != g->colIdx[k - 1]) g->colIdx[m++] = g->colIdx[k];
+        }
+    }
+    g->rowPtr[g->n] = m;
+    g->m = m;
+
+    graph->dirty = calloc(g->n > 0 ? g->n : 1, 1);
+    graph->dirtyRows = malloc((g->n > 0 ? g->n : 1) * sizeof(int));
+    if (!graph->dirty || !graph->dirtyRows) {
+        fprintf(stderr, "Memory allocation error for changed rows\n");
+        freeMutableGraph(graph);
+        return -2;
+    }
+    return 0;
+}
+
+int updateMutableEdge(MutableGraph *graph, int src, int dst, int insert) {
+    if (src < 0 || src >= graph->base.n || dst < 0 || dst >= target_limit(graph)) return -1;
+    if (graph->logCount == graph->logCapacity) {
+        int capacity = graph->logCapacity ? graph->logCapacity * 2 : 256;
+        EdgeUpdate *temp = realloc(graph->log, capacity * sizeof(EdgeUpdate));
+        if (!temp) {
+            fprintf(stderr, "Memory allocation error for the update log\n");
+            return -5;
+        }
+        graph->log = temp;
+        graph->logCapacity = capacity;
+    }
+    EdgeUpdate *update = &graph->log[graph->logCount];
+    update->src = src;
+    update->dst = dst;
+    update->insert = insert;
+    update->seq = graph->logCount;
+    if (graph->logCount > 0 && compare_updates(update - 1, update) > 0) graph->logSorted = 0;
+    graph->logCount++;
+    if (!graph->dirty[src]) {
+        graph->dirty[src] = 1;
+        graph->dirtyRows[graph->dirtyCount++] = src;
+    }
+    if (graph->logCount >= graph->compactAt) return compactMutableGraph(graph);
+    return 0;
+}
+
+int mutableEdgeExists(const MutableGraph *graph, int src, int dst) {
+    if (src < 0 || src >= graph->base.n) return 0;
+    int latest = -1;
+    for (int k = 0; k < graph->logCount; k++) {
+        const EdgeUpdate *update = &graph->log[k];
+        if (update->src == src && update->dst == dst && update->seq > latest) latest = update->seq;
+    }
+    if (latest >= 0) {
+        for (int k = 0; k < graph->logCount; k++) {
+            if (graph->log[k].seq == latest) return graph->log[k].insert;
+        }
+    }
+    const SparseGraph *g = &graph->base;
+    return bsearch(&dst, g->colIdx + g->rowPtr[src], g->rowPtr[src + 1] - g->rowPtr[src],
+                   sizeof(int), compare_ints) != NULL;
+}
+
+static void sort_log(MutableGraph *graph) {
+    if (!graph->logSorted) {
+        qsort(graph->log, graph->logCount, sizeof(EdgeUpdate), compare_updates);
+        graph->logSorted = 1;
+    }
+}
+
+// First entry of the sorted log for row
+static int log_row_start(const MutableGraph *graph, int row) {
+    int low = 0, high = graph->logCount;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (graph->log[mid].src < row) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Current targets of row, sorted: the base row with the latest logged
+   change to each edge applied. Rows without changes are returned straight
+   from the base; others are merged into scratch. Needs a sorted log. */
+static int row_targets(const MutableGraph *graph, int row, int *scratch, const int **targets) {
+    const SparseGraph *g = &graph->base;
+    const int *base = g->colIdx + g->rowPtr[row];
+    int baseCount = g->rowPtr[row + 1] - g->rowPtr[row];
+    int k = log_row_start(graph, row);
+    if (k == graph->logCount || graph->log[k].src != row) {
+        *targets = base;
+        return baseCount;
+    }
+    int i = 0, count = 0;
+    while (i < baseCount || (k < graph->logCount && graph->log[k].src == row)) {
+        if (k < graph->logCount && graph->log[k].src == row && (i == baseCount || graph->log[k].dst <= base[i])) {
+            int dst = graph->log[k].dst;
+            int insert = 0;
+            while (k < graph->logCount && graph->log[k].src == row && graph->log[k].dst == dst) {
+                insert = graph->log[k++].insert;
+            }
+            if (i < baseCount && base[i] == dst) i++;
+            if (insert) scratch[count++] = dst;
+        } else {
+            scratch[count++] = base[i++];
+        }
+    }
+    *targets = scratch;
+    return count;
+}
+
+/* Merges the log into fresh CSR arrays. Costs a pass over the graph, so it
+   only runs once the log is a good fraction of the edge count. */
+int compactMutableGraph(MutableGraph *graph) {
+    if (graph->logCount == 0) return 0;
+    sort_log(graph);
+    SparseGraph *g = &graph->base;
+    int *rowPtr = malloc(((size_t)g->n + 1) * sizeof(int));
+    int *colIdx = malloc(((size_t)g->m + graph->logCount) * sizeof(int));
+    if (!rowPtr || !colIdx) {
+        fprintf(stderr, "Memory allocation error for compaction\n");
+        free(rowPtr);
+        free(colIdx);
+        return -2;
+    }
+    STATS_ALLOC(((size_t)g->n + 1 + g->m + graph->logCount) * sizeof(int));
+    rowPtr[0] = 0;
+    for (int i = 0; i < g->n; i++) {
+        const int *targets;
+        int count = row_targets(graph, i, colIdx + rowPtr[i], &targets);
+        if (targets != colIdx + rowPtr[i]) memcpy(colIdx + rowPtr[i], targets, count * sizeof(int));
+        rowPtr[i + 1] = rowPtr[i] + count;
+    }
+    free(g->rowPtr);
+    free(g->colIdx);
+    g->rowPtr = rowPtr;
+    g->colIdx = colIdx;
+    g->m = rowPtr[g->n];
+    graph->logCount = 0;
+    graph->logSorted = 1;
+    graph->compactAt = g->m / 4 > MUTABLE_MIN_COMPACT ? g->m / 4 : MUTABLE_MIN_COMPACT;
+    return 0;
+}
+
+void freeMutableGraph(MutableGraph *graph) {
+    freeSparseGraph(&graph->base);
+    free(graph->log);
+    free(graph->dirty);
+    free(graph->dirtyRows);
+    graph->log = NULL;
+    graph->dirty = NULL;
+    graph->dirtyRows = NULL;
+    graph->logCount = graph->logCapacity = graph->dirtyCount = 0;
+}
+
+static long dense_row_bytes(int columns) {
+    return (columns > 0 ? (long)columns * 3 - 1 : 0) + 4;
+}
+
+// Characters formatInt writes for value, sign included
+static int digit_count(long value) {
+    int digits = value < 0 ? 2 : 1;
+    if (value < 0) value = -value;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Bytes of the "src - dest" lines of one row
+static long edge_line_bytes(int row, const int *targets, int count) {
+    long bytes = (long)count * (digit_count(row) + 4);
+    for (int k = 0; k < count; k++) bytes += digit_count(targets[k]);
+    return bytes;
+}
+
+static long fixed_line_bytes(const MutableGraph *graph) {
+    long bytes = graph->lineCount * 4;
+    for (long e = 0; e < graph->lineCount; e++) {
+        bytes += digit_count(graph->lineSrc[e]) + digit_count(graph->lineDst[e]);
+    }
+    return bytes;
+}
+
+static int format_edge_line(char *line, int src, int dst) {
+    char *out = formatInt(line, src);
+    memcpy(out, " - ", 3);
+    out = formatInt(out + 3, dst);
+    *out++ = '\n';
+    return (int)(out - line);
+}
+
+static int write_edge_line(FILE *dense, int src, int dst) {
+    char line[32];
+    return (int)fwrite(line, 1, format_edge_line(line, src, dst), dense);
+}
+
+// A row of zeros, as printAdjacencyMatrixToFile writes it; ones are patched in
+static char *zero_row(int columns, long rowBytes) {
+    char *row = malloc(rowBytes);
+    if (!row) return NULL;
+    memcpy(row, " [", 2);
+    for (int j = 0; j < columns; j++) {
+        memcpy(row + 2 + 3 * (size_t)j, j < columns - 1 ? "0. " : "0.", j < columns - 1 ? 3 : 2);
+    }
+    memcpy(row + rowBytes - 2, "]\n", 2);
+    return row;
+}
+
+long mutableDenseSize(MutableGraph *graph) {
+    sort_log(graph);
+    int *scratch = malloc(((size_t)target_limit(graph) + 1) * sizeof(int));
+    if (!scratch) {
+        fprintf(stderr, "Memory allocation error for row buffer\n");
+        return -2;
+    }
+    long size = graph->base.n * dense_row_bytes(graph->columns);
+    if (graph->lineSrc) {
+        size += fixed_line_bytes(graph);
+    } else {
+        for (int i = 0; i < graph->base.n; i++) {
+            const int *targets;
+            int count = row_targets(graph, i, scratch, &targets);
+            size += edge_line_bytes(i, targets, count);
+        }
+    }
+    free(scratch);
+    return size;
+}
+
+static int truncate_file(FILE *file, long size) {
+    if (fflush(file) != 0) return -1;
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), size) == 0 ? 0 : -1;
+#else
+    return ftruncate(fileno(file), size);
+#endif
+}
+
+int exportMutableDense(MutableGraph *graph, FILE *dense, int full) {
+    if (!full && graph->dirtyCount == 0 && graph->lineKept >= graph->lineCount) return 0;
+    sort_log(graph);
+    const SparseGraph *g = &graph->base;
+    int columns = graph->columns;
+    long rowBytes = dense_row_bytes(columns);
+    int *scratch = malloc(((size_t)target_limit(graph) + 1) * sizeof(int));
+    char *row = zero_row(columns, rowBytes);
+    if (!scratch || !row) {
+        fprintf(stderr, "Memory allocation error for row buffer\n");
+        free(scratch);
+        free(row);
+        return -2;
+    }
+
+    int rowsToWrite = full ? g->n : graph->dirtyCount;
+    int firstChanged = g->n;
+    int failed = 0;
+    long written = 0;
+    for (int r = 0; r < rowsToWrite && !failed; r++) {
+        int i = full ? r : graph->dirtyRows[r];
+        if (i < firstChanged) firstChanged = i;
+        const int *targets;
+        int count = row_targets(graph, i, scratch, &targets);
+        for (int k = 0; k < count; k++) row[2 + 3 * (size_t)targets[k]] = '1';
+        failed = fseek(dense, i * rowBytes, SEEK_SET) != 0 || fwrite(row, 1, rowBytes, dense) != (size_t)rowBytes;
+        for (int k = 0; k < count; k++) row[2 + 3 * (size_t)targets[k]] = '0';
+        written += rowBytes;
+    }
+
+    long offset = g->n * rowBytes;
+    if (graph->lineSrc) {
+        // These lines do not follow the rows; the leading lineKept are already in place
+        long first = full ? 0 : graph->lineKept;
+        for (long e = 0; e < first; e++) offset += digit_count(graph->lineSrc[e]) + digit_count(graph->lineDst[e]) + 4;
+        if (first < graph->lineCount && !failed) failed = fseek(dense, offset, SEEK_SET) != 0;
+        for (long e = first; e < graph->lineCount && !failed; e++) {
+            int length = write_edge_line(dense, graph->lineSrc[e], graph->lineDst[e]);
+            offset += length;
+            written += length;
+        }
+    } else {
+        // Edge lines of the rows before the first changed one are already in place
+        for (int i = 0; i < firstChanged; i++) {
+            const int *targets;
+            int count = row_targets(graph, i, scratch, &targets);
+            offset += edge_line_bytes(i, targets, count);
+        }
+        if (!failed) failed = fseek(dense, offset, SEEK_SET) != 0;
+        for (int i = firstChanged; i < g->n && !failed; i++) {
+            const int *targets;
+            int count = row_targets(graph, i, scratch, &targets);
+            for (int k = 0; k < count; k++) {
+                int length = write_edge_line(dense, i, targets[k]);
+                offset += length;
+                written += length;
+            }
+        }
+    }
+    if (!failed) failed = ferror(dense);
+    // Without new edge lines the file keeps its length
+    if (!failed && (full || !graph->lineSrc || graph->lineKept < graph->lineCount)) {
+        failed = truncate_file(dense, offset) != 0;
+    }
+    free(scratch);
+    free(row);
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    if (failed) {
+        fprintf(stderr, "Error writing updated graf.txt\n");
+        return -3;
+    }
+    for (int r = 0; r < graph->dirtyCount; r++) graph->dirty[graph->dirtyRows[r]] = 0;
+    graph->dirtyCount = 0;
+    graph->lineKept = graph->lineCount;
+    return 0;
+}
+
+// ---- graph_gen --update ----
+
+#define DENSE_CHECK_BUFFER (1 << 16)  // Edge line bytes compared at a time
+#define SECTION_BUFFER (1 << 16)      // Output buffer for renumbered sections
+
+/* The edge sections of the input, in file order as the converter prints
+   them, and where they start in the file. */
+typedef struct SectionEdges {
+    int *src;
+    int *dst;
+    long count;
+    long capacity;
+    long offset;
+} SectionEdges;
+
+/* Section vertex ids are positions in line 2, so inserting or deleting an
+   entry moves every vertex after it. Per position: the entry's index in the
+   base, then its position in the updated line 2; -1 once it is gone. */
+typedef struct LinePositions {
+    int *entry;
+    int count;
+} LinePositions;
+
+static void free_section_edges(SectionEdges *edges) {
+    free(edges->src);
+    free(edges->dst);
+    edges->src = edges->dst = NULL;
+    edges->count = edges->capacity = 0;
+}
+
+static int append_section_edges(SectionEdges *edges, const CsrrgSection *section) {
+    if (edges->count + section->edges > edges->capacity) {
+        long capacity = edges->capacity ? edges->capacity : 1024;
+        while (capacity < edges->count + section->edges) capacity *= 2;
+        int *src = realloc(edges->src, capacity * sizeof(int));
+        if (src) edges->src = src;
+        int *dst = src ? realloc(edges->dst, capacity * sizeof(int)) : NULL;
+        if (!dst) {
+            fprintf(stderr, "Memory allocation error for section edges\n");
+            return -5;
+        }
+        edges->dst = dst;
+        edges->capacity = capacity;
+    }
+    for (long e = 0; e < section->edges; e++) {
+        edges->src[edges->count] = (int)getInt32LE(section->text + 8 * e);
+        edges->dst[edges->count++] = (int)getInt32LE(section->text + 8 * e + 4);
+    }
+    return 0;
+}
+
+static int read_section_edges(FILE *f, SectionEdges *edges) {
+    CsrrgSection section = {0};
+    section.style = CSRRG_EDGES_BINARY;
+    char *line = NULL;
+    size_t capacity = 0;
+    int status;
+    while ((status = readCsrrgEdgeSection(f, &line, &capacity, &section)) > 0) {
+        status = formatCsrrgEdgeSection(&section);
+        free(section.edgeLine);
+        free(section.pointerLine);
+        section.edgeLine = section.pointerLine = NULL;
+        if (status == 0) status = append_section_edges(edges, &section);
+        if (status != 0) break;
+    }
+    freeCsrrgSection(&section);
+    free(line);
+    return status == -1 ? 0 : status;  // An incomplete last section is ignored, as when converting
+}
+
+// Sections written by writeCsrrgFile / writeSparseCsrrgFile list exactly the matrix entries
+static int sections_mirror_rows(const SectionEdges *edges, const SparseGraph *rows) {
+    if (edges->count != rows->m) return 0;
+    long e = 0;
+    for (int i = 0; i < rows->n; i++) {
+        for (int k = rows->rowPtr[i]; k < rows->rowPtr[i + 1]; k++, e++) {
+            if (edges->src[e] != i || edges->dst[e] != rows->colIdx[k]) return 0;
+        }
+    }
+    return 1;
+}
+
+// Next token as strtok_r(..., ";") cuts it, without changing the line; NULL at the end
+static const char *next_token(const char *p, const char **end) {
+    while (*p == ';') p++;
+    if (!*p) return NULL;
+    *end = strchr(p, ';');
+    if (!*end) *end = p + strlen(p);
+    return p;
+}
+
+/* Finds every line 2 entry in the grid, reading the tokens row by row as
+   buildCsrrgGrid does. Entries the grid dropped map to -1. */
+static int read_line_positions(const CsrrgHeader *header, const SparseGraph *grid, LinePositions *positions) {
+    long capacity = 1;
+    for (int row = 0; row < header->numRows; row++) {
+        if (header->rowCounts[row] > 0) capacity += header->rowCounts[row];
+    }
+    positions->entry = malloc(capacity * sizeof(int));
+    positions->count = 0;
+    if (!positions->entry) {
+        fprintf(stderr, "Memory allocation error for line 2 positions\n");
+        return -2;
+    }
+    const char *end = header->line2;
+    const char *token = next_token(end, &end);
+    for (int row = 0; row < header->numRows; row++) {
+        const int *cells = grid->colIdx + grid->rowPtr[row];
+        int cellCount = grid->rowPtr[row + 1] - grid->rowPtr[row];
+        for (int j = 0; j < header->rowCounts[row] && token; j++) {
+            int column = atoi(token);
+            const int *cell = bsearch(&column, cells, cellCount, sizeof(int), compare_ints);
+            positions->entry[positions->count++] = cell ? (int)(cell - grid->colIdx) : -1;
+            token = next_token(end, &end);
+        }
+    }
+    return 0;
+}
+
+/* Loads the matrix of lines 2 and 3 and the edge sections. The log is only
+   merged on request, so the base stays the state before the updates. */
+static int load_csrrg(const char *fileName, MutableGraph *graph, SectionEdges *edges, LinePositions *positions,
+                      int *maxRowNodes) {
+    FILE *f = fopen(fileName, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", fileName);
+        return -4;
+    }
+    CsrrgHeader header;
+    int status = readCsrrgHeader(f, &header);
+    if (status != 0) {
+        fclose(f);
+        return status;
+    }
+    *maxRowNodes = header.maxRowNodes;
+    edges->offset = ftell(f);
+    status = read_section_edges(f, edges);
+    fclose(f);
+    SparseGraph grid = {0};
+    if (status == 0) status = buildCsrrgRowCounts(&header);
+    if (status == 0) status = buildCsrrgGrid(&header, &grid);
+    int mirrored = status == 0 && sections_mirror_rows(edges, &grid);
+    if (status == 0 && !mirrored) status = read_line_positions(&header, &grid, positions);
+    int columns = header.columns;
+    freeCsrrgHeader(&header);
+    if (status == 0) {
+        status = initMutableGraph(graph, &grid, columns);
+    } else {
+        freeSparseGraph(&grid);
+    }
+    if (status != 0) {
+        free_section_edges(edges);
+        free(positions->entry);
+        positions->entry = NULL;
+        return status;
+    }
+    graph->compactAt = INT_MAX;
+    if (!mirrored) {
+        graph->lineSrc = edges->src;
+        graph->lineDst = edges->dst;
+        graph->lineCount = edges->count;
+        graph->lineKept = edges->count;
+    }
+    return 0;
+}
+
+/* Applies "+ src dest" and "- src dest" lines; blank lines and lines
+   starting with '#' are skipped. */
+static int apply_update_file(const char *fileName, MutableGraph *graph, int *applied) {
+    FILE *f = fopen(fileName, "r");
+    if (!f) {
+        fprintf(stderr, "Error opening file %s\n", fileName);
+        return -4;
+    }
+    char line[256];
+    int lineNumber = 0;
+    int status = 0;
+    *applied = 0;
+    while (status == 0 && fgets(line, sizeof(line), f)) {
+        lineNumber++;
+        if (isEmptyLine(line) || line[0] == '#') continue;
+        char op;
+        int src, dst;
+        if (sscanf(line, " %c %d %d", &op, &src, &dst) != 3 || (op != '+' && op != '-')) {
+            fprintf(stderr, "%s:%d: expected \"+ src dest\" or \"- src dest\"\n", fileName, lineNumber);
+            status = -1;
+        } else {
+            status = updateMutableEdge(graph, src, dst, op == '+');
+            if (status == -1) {
+                fprintf(stderr, "%s:%d: edge %d - %d out of range for %d rows\n", fileName, lineNumber,
+                        src, dst, graph->base.n);
+            } else if (status == 0) {
+                (*applied)++;
+            }
+        }
+    }
+    fclose(f);
+    return status;
+}
+
+/* Moves every position to where its entry ends up once the log is merged;
+   deleted entries become -1. Runs before compactMutableGraph, while the
+   base is still the state the positions were read for. */
+static int move_line_positions(MutableGraph *graph, LinePositions *positions) {
+    const SparseGraph *g = &graph->base;
+    int *moved = malloc(((size_t)g->m + 1) * sizeof(int));
+    int *scratch = malloc(((size_t)target_limit(graph) + 1) * sizeof(int));
+    if (!moved || !scratch) {
+        fprintf(stderr, "Memory allocation error for line 2 positions\n");
+        free(moved);
+        free(scratch);
+        return -2;
+    }
+    sort_log(graph);
+    int next = 0;
+    for (int i = 0; i < g->n; i++) {
+        const int *targets;
+        int count = row_targets(graph, i, scratch, &targets);
+        int j = 0;
+        for (int k = g->rowPtr[i]; k < g->rowPtr[i + 1]; k++) {
+            while (j < count && targets[j] < g->colIdx[k]) j++;
+            moved[k] = j < count && targets[j] == g->colIdx[k] ? next + j : -1;
+        }
+        next += count;
+    }
+    for (int t = 0; t < positions->count; t++) {
+        if (positions->entry[t] >= 0) positions->entry[t] = moved[positions->entry[t]];
+    }
+    free(moved);
+    free(scratch);
+    return 0;
+}
+
+static int positions_moved(const LinePositions *positions) {
+    for (int t = 0; t < positions->count; t++) {
+        if (positions->entry[t] != t) return 1;
+    }
+    return 0;
+}
+
+static int new_position(const LinePositions *positions, long vertex) {
+    return vertex >= 0 && vertex < positions->count ? positions->entry[vertex] : -1;
+}
+
+/* graf.txt can only be patched if it is the conversion of the state before
+   the updates. The size is checked first, then the whole file is read back
+   and compared with that state, so a graf.txt of the same size from
+   another graph is rewritten rather than patched. */
+static int dense_matches(MutableGraph *graph, FILE *dense, long expected) {
+    if (fseek(dense, 0, SEEK_END) != 0 || ftell(dense) != expected || fseek(dense, 0, SEEK_SET) != 0) return 0;
+    const SparseGraph *g = &graph->base;
+    long rowBytes = dense_row_bytes(graph->columns);
+    char *row = zero_row(graph->columns, rowBytes);
+    char *found = malloc(rowBytes);
+    int matches = row && found;
+    for (int i = 0; i < g->n && matches; i++) {
+        for (int k = g->rowPtr[i]; k < g->rowPtr[i + 1]; k++) row[2 + 3 * (size_t)g->colIdx[k]] = '1';
+        matches = fread(found, 1, rowBytes, dense) == (size_t)rowBytes && memcmp(row, found, rowBytes) == 0;
+        for (int k = g->rowPtr[i]; k < g->rowPtr[i + 1]; k++) row[2 + 3 * (size_t)g->colIdx[k]] = '0';
+    }
+    // The edge lines are compared a buffer at a time
+    long lineCount = graph->lineSrc ? graph->lineCount : g->m;
+    char *lines = matches ? malloc(DENSE_CHECK_BUFFER) : NULL;
+    char *read = matches ? malloc(DENSE_CHECK_BUFFER) : NULL;
+    matches = matches && lines && read;
+    size_t used = 0;
+    int i = 0;
+    for (long e = 0; e <= lineCount && matches; e++) {
+        if (e == lineCount || used > DENSE_CHECK_BUFFER - 32) {
+            matches = fread(read, 1, used, dense) == used && memcmp(lines, read, used) == 0;
+            used = 0;
+        }
+        if (e == lineCount) break;
+        if (graph->lineSrc) {
+            used += format_edge_line(lines + used, graph->lineSrc[e], graph->lineDst[e]);
+        } else {
+            while (e >= g->rowPtr[i + 1]) i++;
+            used += format_edge_line(lines + used, i, g->colIdx[e]);
+        }
+    }
+    free(row);
+    free(found);
+    free(lines);
+    free(read);
+    STATS_ADD(STATS_BYTES_READ, expected);
+    return matches;
+}
+
+static int copy_bytes(FILE *from, FILE *to) {
+    char buffer[1 << 16];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+        if (fwrite(buffer, 1, got, to) != got) return -3;
+    }
+    return ferror(from) ? -4 : 0;
+}
+
+typedef struct SectionOutput {
+    FILE *file;
+    size_t used;
+    char data[SECTION_BUFFER];
+} SectionOutput;
+
+static void put_section_bytes(SectionOutput *out, const char *bytes, size_t length) {
+    if (out->used + length > sizeof(out->data)) {
+        fwrite(out->data, 1, out->used, out->file);
+        out->used = 0;
+    }
+    if (length > sizeof(out->data)) {
+        fwrite(bytes, 1, length, out->file);
+    } else {
+        memcpy(out->data + out->used, bytes, length);
+        out->used += length;
+    }
+}
+
+/* Writes an edge section with every vertex at its new position. The groups,
+   the pointer line and the tokens the converter skips after the last group
+   stay as they are. Returns -1 if a vertex has no new position. */
+static int write_moved_section(SectionOutput *out, const CsrrgSection *section, int index,
+                               const LinePositions *positions) {
+    // Tokens in groups, as formatCsrrgEdgeSection reads the pointers
+    long grouped = 0;
+    int first = 1, prev = 0;
+    const char *end;
+    for (const char *p = next_token(section->pointerLine, &end); p; p = next_token(end, &end)) {
+        int current = atoi(p);
+        if (!first && current > prev) grouped += current - prev;
+        first = 0;
+        prev = current;
+    }
+
+    const char *copied = section->edgeLine;
+    long t = 0;
+    for (const char *p = next_token(copied, &end); p && t < grouped; p = next_token(end, &end), t++) {
+        char *digits;
+        long vertex = strtol(p, &digits, 10);
+        int moved = new_position(positions, vertex);
+        if (moved < 0) {
+            fprintf(stderr, "Edge section %d: vertex %ld has no line 2 entry after the updates, "
+                    "so the edge sections cannot be kept\n", index, vertex);
+            return -1;
+        }
+        // Whatever surrounds the number (spaces, the line end) is kept
+        const char *number = p;
+        while (number < digits && (*number == ' ' || *number == '\t')) number++;
+        if (digits == p) digits = (char *)number;
+        char text[16];
+        put_section_bytes(out, copied, number - copied);
+        put_section_bytes(out, text, formatInt(text, moved) - text);
+        copied = digits;
+    }
+    put_section_bytes(out, copied, strlen(copied));
+    put_section_bytes(out, section->pointerLine, strlen(section->pointerLine));
+    return 0;
+}
+
+// Copies the sections from source with their vertices moved, see write_moved_section
+static int move_sections(FILE *source, FILE *file, const LinePositions *positions) {
+    if (!positions_moved(positions)) return copy_bytes(source, file);
+
+    SectionOutput *out = malloc(sizeof(SectionOutput));
+    if (!out) {
+        fprintf(stderr, "Memory allocation error for section output\n");
+        return -2;
+    }
+    out->file = file;
+    out->used = 0;
+    CsrrgSection section = {0};
+    char *line = NULL;
+    size_t capacity = 0;
+    int status, index = 0, refused = 0;
+    long start = ftell(source);
+    while ((status = readCsrrgEdgeSection(source, &line, &capacity, &section)) > 0) {
+        status = write_moved_section(out, &section, ++index, positions);
+        free(section.edgeLine);
+        free(section.pointerLine);
+        section.edgeLine = section.pointerLine = NULL;
+        if (status != 0) {
+            refused = 1;
+            break;
+        }
+        start = ftell(source);
+    }
+    fwrite(out->data, 1, out->used, file);
+    // An incomplete last section is ignored when converting; it stays as it was
+    if (status == -1 && !refused) status = fseek(source, start, SEEK_SET) == 0 ? copy_bytes(source, file) : -4;
+    freeCsrrgSection(&section);
+    free(line);
+    free(out);
+    return status;
+}
+
+/* Writes the updated .csrrg to temp. Mirrored sections are generated again
+   from the rows; any others are copied from the input after the new lines
+   1-3, with their vertices moved to the new line 2 positions. */
+static int write_updated_csrrg(const char *input, const char *temp, const MutableGraph *graph,
+                               const LinePositions *positions, long offset, int maxRowNodes) {
+    FILE *file = fopen(temp, "w");
+    if (!file) {
+        fprintf(stderr, "Error opening output file %s\n", temp);
+        return -3;
+    }
+    int status = -4;
+    if (!graph->lineSrc) {
+        status = writeSparseCsrrgFile(file, &graph->base);
+    } else {
+        FILE *source = fopen(input, "r");
+        if (source) {
+            fprintf(file, "%d\n", maxRowNodes);
+            status = writeSparseCsrrgGrid(file, &graph->base);
+            if (status == 0) status = fseek(source, offset, SEEK_SET) == 0 ? move_sections(source, file, positions) : -4;
+            fclose(source);
+        } else {
+            fprintf(stderr, "Error opening file %s\n", input);
+        }
+    }
+    if (status == 0 && ferror(file)) status = -3;
+    if (fclose(file) != 0 && status == 0) status = -3;
+    if (status == -3) fprintf(stderr, "Error writing %s\n", temp);
+    return status;
+}
+
+/* Moves the graf.txt edge lines along with the sections; returns how many
+   leading lines are unchanged. */
+static long move_section_edges(SectionEdges *edges, const LinePositions *positions) {
+    long kept = edges->count;
+    for (long e = 0; e < edges->count; e++) {
+        int src = new_position(positions, edges->src[e]);
+        int dst = new_position(positions, edges->dst[e]);
+        if (kept == edges->count && (src != edges->src[e] || dst != edges->dst[e])) kept = e;
+        edges->src[e] = src;
+        edges->dst[e] = dst;
+    }
+    return kept;
+}
+
+int updateCsrrgFile(int argc, char **argv) {
+    if (argc < 4 || argc > 5) {
+        fprintf(stderr, "Usage: --update file.csrrg updates.txt [out.csrrg]\n");
+        return -1;
+    }
+    MutableGraph graph;
+    SectionEdges edges = {0};
+    LinePositions positions = {0};
+    int maxRowNodes;
+    int status = load_csrrg(argv[2], &graph, &edges, &positions, &maxRowNodes);
+    if (status != 0) return status;
+
+    long expected = mutableDenseSize(&graph);
+    int applied = 0;
+    status = expected < 0 ? (int)expected : apply_update_file(argv[3], &graph, &applied);
+    int changedRows = graph.dirtyCount;
+    FILE *dense = NULL;
+    int full = 1;
+    if (status == 0) {
+        dense = fopen("graf.txt", "r+b");
+        if (dense && dense_matches(&graph, dense, expected)) full = 0;
+        if (graph.lineSrc) status = move_line_positions(&graph, &positions);
+    }
+    if (status == 0) status = compactMutableGraph(&graph);
+    if (status == 0) {
+        // The dense width follows the highest column; if it moved every row changes
+        int columns = 0;
+        for (int k = 0; k < graph.base.m; k++) {
+            if (graph.base.colIdx[k] + 1 > columns) columns = graph.base.colIdx[k] + 1;
+        }
+        if (columns != graph.columns) full = 1;
+        graph.columns = columns;
+    }
+
+    // The .csrrg is written first, so sections that cannot be kept leave graf.txt untouched
+    const char *output = argc > 4 ? argv[4] : argv[2];
+    size_t length = strlen(output);
+    char *temp = status == 0 ? malloc(length + 5) : NULL;
+    if (temp) {
+        memcpy(temp, output, length);
+        memcpy(temp + length, ".tmp", 5);
+        status = write_updated_csrrg(argv[2], temp, &graph, &positions, edges.offset, maxRowNodes);
+    } else if (status == 0) {
+        fprintf(stderr, "Memory allocation error for file name\n");
+        status = -2;
+    }
+    if (status == 0 && graph.lineSrc) graph.lineKept = move_section_edges(&edges, &positions);
+
+    if (status == 0 && !dense) {
+        dense = fopen("graf.txt", "w+b");
+        if (!dense) {
+            fprintf(stderr, "Error opening output file graf.txt\n");
+            status = -3;
+        }
+    }
+    if (status == 0) status = exportMutableDense(&graph, dense, full);
+    if (dense && fclose(dense) != 0 && status == 0) {
+        fprintf(stderr, "Error writing updated graf.txt\n");
+        status = -3;
+    }
+    if (temp) {
+        if (status == 0 && rename(temp, output) != 0) {
+            fprintf(stderr, "Error writing %s\n", output);
+            status = -3;
+        }
+        if (status != 0) remove(temp);
+        free(temp);
+    }
+    if (status == 0) {
+        printf("%d update(s), %d row(s) changed, graf.txt %s%s%s\n", applied, changedRows,
+               full ? "rewritten" : "patched in place", graph.lineSrc ? ", edge sections kept" : "",
+               positions_moved(&positions) ? " with their vertices renumbered" : "");
+    }
+    free_section_edges(&edges);
+    free(positions.entry);
+    freeMutableGraph(&graph);
+    return status;
+}
@@ -0,0 +1,62 @@
+#ifndef MUTABLE_GRAPH_H
+#define MUTABLE_GRAPH_H
+
+#include <stdio.h>
+#include "sparse_graph.h"
+
+#define MUTABLE_MIN_COMPACT 4096  // Shortest log that triggers compaction
+
+// One logged change: the edge src -> dst added (insert = 1) or removed
+typedef struct EdgeUpdate {
+    int src;
+    int dst;
+    int insert;
+    int seq;      // Position in the log, so the latest change to an edge wins
+} EdgeUpdate;
+
+/* A graph that takes edge changes without rebuilding its CSR arrays each
+   time: changes go to a log that is merged into fresh arrays once it grows
+   past compactAt. The rows touched since the last export are tracked, so
+   exports only rewrite those. */
+typedef struct MutableGraph {
+    SparseGraph base;       // Compacted state, every row sorted and without duplicates
+    int columns;            // Width of the dense rows
+    EdgeUpdate *log;
+    int logCount;
+    int logCapacity;
+    int logSorted;          // log is ordered by (src, dst, seq)
+    int compactAt;
+    unsigned char *dirty;   // Per row: changed since the last export
+    int *dirtyRows;
+    int dirtyCount;
+    /* The "src - dest" lines of graf.txt when they are not the edges of the
+       rows, as for edge sections that do not mirror the matrix. They are
+       exported as they are; NULL means the rows' own edges. The first
+       lineKept lines are already in graf.txt and not written again. */
+    const int *lineSrc;
+    const int *lineDst;
+    long lineCount;
+    long lineKept;
+} MutableGraph;
+
+// Takes over base; sorts its rows and drops duplicate edges
+int initMutableGraph(MutableGraph *graph, SparseGraph *base, int columns);
+// Logs a change; returns -1 if src or dst is out of range
+int updateMutableEdge(MutableGraph *graph, int src, int dst, int insert);
+int mutableEdgeExists(const MutableGraph *graph, int src, int dst);
+int compactMutableGraph(MutableGraph *graph);
+void freeMutableGraph(MutableGraph *graph);
+
+/* Size of graf.txt for the graph as it is now: fixed-width dense rows
+   followed by one "src - dest" line per edge (or per entry of lineSrc). */
+long mutableDenseSize(MutableGraph *graph);
+/* Brings a graf.txt written for the state at the last export up to date:
+   changed rows are rewritten in place, then the edge lines from the first
+   changed row on (with lineSrc set, from lineKept on) are written again.
+   With full set everything is written. Clears the changed rows. */
+int exportMutableDense(MutableGraph *graph, FILE *dense, int full);
+
+// graph_gen --update file.csrrg updates.txt [out.csrrg]
+int updateCsrrgFile(int argc, char **argv);
+
+#endif // MUTABLE_GRAPH_H
@@ -0,0 +1,68 @@
+#include "sparse_graph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Builds the CSR arrays from parallel src/dst edge arrays with a counting
+   sort on the source, so edges keep their input order inside each row. */
+int buildSparseGraph(int n, const int *src, const int *dst, int m, SparseGraph *graph) {
+    graph->n = n;
+    graph->m = m;
+    graph->rowPtr = calloc((size_t)n + 1, sizeof(int));
+    graph->colIdx = malloc((m > 0 ? (size_t)m : 1) * sizeof(int));
+    if (!graph->rowPtr || !graph->colIdx) {
+        fprintf(stderr, "Memory allocation error for sparse graph\n");
+        freeSparseGraph(graph);
+        return -2;
+    }
+
+    for (int e = 0; e < m; e++) {
+        graph->rowPtr[src[e] + 1]++;
+    }
+    for (int i = 0; i < n; i++) {
+        graph->rowPtr[i + 1] += graph->rowPtr[i];
+    }
+    int *fill = malloc(((size_t)n + 1) * sizeof(int));
+    if (!fill) {
+        fprintf(stderr, "Memory allocation error for sparse graph fill pointers\n");
+        freeSparseGraph(graph);
+        return -2;
+    }
+    memcpy(fill, graph->rowPtr, ((size_t)n + 1) * sizeof(int));
+    for (int e = 0; e < m; e++) {
+        graph->colIdx[fill[src[e]]++] = dst[e];
+    }
+    free(fill);
+    return 0;
+}
+
+AdjacencyMatrix sparseGraphToMatrix(const SparseGraph *graph) {
+    AdjacencyMatrix matrix = createAdjacencyMatrix(graph->n, graph->n);
+    if (!matrix.matrix) {
+        return matrix;
+    }
+    for (int i = 0; i < graph->n; i++) {
+        for (int k = graph->rowPtr[i]; k < graph->rowPtr[i + 1]; k++) {
+            matrix.matrix[i][graph->colIdx[k]] = 1;
+        }
+    }
+    return matrix;
+}
+
+void printSparseConnectionsToFile(FILE *file, const SparseGraph *graph) {
+    for (int i = 0; i < graph->n; i++) {
+        for (int k = graph->rowPtr[i]; k < graph->rowPtr[i + 1]; k++) {
+            fprintf(file, "%d - %d\n", i, graph->colIdx[k]);
+        }
+    }
+}
+
+void freeSparseGraph(SparseGraph *graph) {
+    free(graph->rowPtr);
+    free(graph->colIdx);
+    graph->rowPtr = NULL;
+    graph->colIdx = NULL;
+    graph->n = 0;
+    graph->m = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef SPARSE_GRAPH_H
+#define SPARSE_GRAPH_H
+
+#include <stdio.h>
+#include "graph_matrix.h"
+
+// Directed graph in compressed sparse row form: the targets of vertex i are
+// colIdx[rowPtr[i]] .. colIdx[rowPtr[i + 1] - 1], in input order.
+typedef struct SparseGraph {
+    int n;        // Number of vertices
+    int m;        // Number of edges
+    int *rowPtr;  // n + 1 entries
+    int *colIdx;  // m entries
+} SparseGraph;
+
+int buildSparseGraph(int n, const int *src, const int *dst, int m, SparseGraph *graph);
+AdjacencyMatrix sparseGraphToMatrix(const SparseGraph *graph);
+void printSparseConnectionsToFile(FILE *file, const SparseGraph *graph);
+void freeSparseGraph(SparseGraph *graph);
+
+#endif // SPARSE_GRAPH_H
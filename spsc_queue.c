@@ -0,0 +1,82 @@
+#include "spsc_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <time.h>
+#endif
+
+#define SPSC_YIELD_SPINS 64  // Yields before a waiting side starts sleeping
+
+int initSpscQueue(SpscQueue *queue, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    queue->slots = malloc(size * sizeof(void *));
+    if (!queue->slots) {
+        fprintf(stderr, "Memory allocation error for queue\n");
+        return -2;
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->closed, 0);
+    return 0;
+}
+
+/* Gives the other side a chance to run: yield first, then sleep briefly
+   so a long wait (e.g. on the disk) does not keep a core busy. */
+static void spsc_wait(int *spins) {
+    if (++*spins < SPSC_YIELD_SPINS) {
+#ifdef _WIN32
+        Sleep(0);
+#else
+        sched_yield();
+#endif
+    } else {
+#ifdef _WIN32
+        Sleep(1);
+#else
+        struct timespec pause = {0, 50000};
+        nanosleep(&pause, NULL);
+#endif
+    }
+}
+
+void spscPush(SpscQueue *queue, void *item) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    int spins = 0;
+    while (tail - atomic_load_explicit(&queue->head, memory_order_acquire) > queue->mask) {
+        spsc_wait(&spins);
+    }
+    queue->slots[tail & queue->mask] = item;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+}
+
+void *spscPop(SpscQueue *queue) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    int spins = 0;
+    while (head == atomic_load_explicit(&queue->tail, memory_order_acquire)) {
+        if (atomic_load_explicit(&queue->closed, memory_order_acquire)) {
+            // Re-check: items pushed before the close must still come out
+            if (head == atomic_load_explicit(&queue->tail, memory_order_acquire)) return NULL;
+            break;
+        }
+        spsc_wait(&spins);
+    }
+    void *item = queue->slots[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return item;
+}
+
+// Called by the producer after its last push
+void closeSpscQueue(SpscQueue *queue) {
+    atomic_store_explicit(&queue->closed, 1, memory_order_release);
+}
+
+void freeSpscQueue(SpscQueue *queue) {
+    free(queue->slots);
+    queue->slots = NULL;
+}
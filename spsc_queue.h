@@ -0,0 +1,24 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* Bounded lock-free queue of pointers between exactly one producer thread
+   and one consumer thread. Push blocks while the queue is full, pop blocks
+   while it is empty and returns NULL once it is closed and drained. */
+typedef struct SpscQueue {
+    void **slots;
+    size_t mask;               // Capacity - 1, capacity is a power of two
+    _Atomic size_t head;       // Next slot to pop, written by the consumer
+    _Atomic size_t tail;       // Next slot to push, written by the producer
+    _Atomic int closed;
+} SpscQueue;
+
+int initSpscQueue(SpscQueue *queue, size_t capacity);
+void spscPush(SpscQueue *queue, void *item);
+void *spscPop(SpscQueue *queue);
+void closeSpscQueue(SpscQueue *queue);
+void freeSpscQueue(SpscQueue *queue);
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,103 @@
+#include "stats.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+int statsEnabled = 0;
+
+static const char *phaseNames[STATS_PHASE_COUNT] = {
+    "header_parse", "row_counts", "matrix_fill", "dense_print", "edge_sections",
+    "generate", "api_request", "response_parse", "print"
+};
+
+static const char *counterNames[STATS_COUNTER_COUNT] = {
+    "bytes_read", "bytes_written", "tokens_parsed", "edges_emitted", "alloc_count", "alloc_bytes"
+};
+
+// Atomic so batch workers can report into the same totals
+static _Atomic uint64_t phaseNanos[STATS_PHASE_COUNT];
+static _Atomic uint64_t phaseCalls[STATS_PHASE_COUNT];
+static _Atomic uint64_t counters[STATS_COUNTER_COUNT];
+
+static uint64_t now_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Returns the start timestamp to hand to statsPhaseEnd, or 0 when disabled
+uint64_t statsPhaseBegin(void) {
+    return statsEnabled ? now_nanos() : 0;
+}
+
+void statsPhaseEnd(StatsPhase phase, uint64_t start) {
+    if (!statsEnabled || start == 0) return;
+    atomic_fetch_add_explicit(&phaseNanos[phase], now_nanos() - start, memory_order_relaxed);
+    atomic_fetch_add_explicit(&phaseCalls[phase], 1, memory_order_relaxed);
+}
+
+void statsAdd(StatsCounter counter, uint64_t value) {
+    atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+}
+
+long statsPeakRssKb(void) {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss;  // Kilobytes on Linux
+    }
+#endif
+    return -1;
+}
+
+/* Handles "--stats", "--stats=human" and "--stats=json". Returns 1 if the
+   argument was a stats option (and enables collection), 0 otherwise. */
+int statsParseOption(const char *arg) {
+    if (strcmp(arg, "--stats") == 0 || strcmp(arg, "--stats=human") == 0) {
+        statsEnabled = 1;
+        return 1;
+    } else if (strcmp(arg, "--stats=json") == 0) {
+        statsEnabled = 2;
+        return 1;
+    }
+    return 0;
+}
+
+void statsPrint(FILE *out, int json) {
+    if (json) {
+        fprintf(out, "{\"phases\": {");
+        int first = 1;
+        for (int i = 0; i < STATS_PHASE_COUNT; i++) {
+            uint64_t calls = atomic_load(&phaseCalls[i]);
+            if (calls == 0) continue;
+            fprintf(out, "%s\"%s\": {\"calls\": %llu, \"seconds\": %.9f}", first ? "" : ", ", phaseNames[i],
+                    (unsigned long long)calls, atomic_load(&phaseNanos[i]) / 1e9);
+            first = 0;
+        }
+        fprintf(out, "}, \"counters\": {");
+        for (int i = 0; i < STATS_COUNTER_COUNT; i++) {
+            fprintf(out, "%s\"%s\": %llu", i ? ", " : "", counterNames[i],
+                    (unsigned long long)atomic_load(&counters[i]));
+        }
+        fprintf(out, "}, \"peak_rss_kb\": %ld}\n", statsPeakRssKb());
+        return;
+    }
+
+    fprintf(out, "--- stats ---\n");
+    fprintf(out, "%-16s %8s %12s\n", "phase", "calls", "total ms");
+    for (int i = 0; i < STATS_PHASE_COUNT; i++) {
+        uint64_t calls = atomic_load(&phaseCalls[i]);
+        if (calls == 0) continue;
+        fprintf(out, "%-16s %8llu %12.3f\n", phaseNames[i], (unsigned long long)calls,
+                atomic_load(&phaseNanos[i]) / 1e6);
+    }
+    for (int i = 0; i < STATS_COUNTER_COUNT; i++) {
+        fprintf(out, "%-16s %llu\n", counterNames[i], (unsigned long long)atomic_load(&counters[i]));
+    }
+    fprintf(out, "%-16s %ld KB\n", "peak_rss", statsPeakRssKb());
+}
@@ -0,0 +1,46 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Timed phases, reported in this order
+typedef enum StatsPhase {
+    STATS_HEADER_PARSE,
+    STATS_ROW_COUNTS,
+    STATS_MATRIX_FILL,
+    STATS_DENSE_PRINT,
+    STATS_EDGE_SECTIONS,
+    STATS_GENERATE,
+    STATS_API_REQUEST,
+    STATS_RESPONSE_PARSE,
+    STATS_PRINT,
+    STATS_PHASE_COUNT
+} StatsPhase;
+
+typedef enum StatsCounter {
+    STATS_BYTES_READ,
+    STATS_BYTES_WRITTEN,
+    STATS_TOKENS_PARSED,
+    STATS_EDGES_EMITTED,
+    STATS_ALLOC_COUNT,
+    STATS_ALLOC_BYTES,
+    STATS_COUNTER_COUNT
+} StatsCounter;
+
+// Set by --stats; everything below is a single branch while it is 0
+extern int statsEnabled;
+
+#define STATS_ADD(counter, value) \
+    do { if (statsEnabled) statsAdd((counter), (uint64_t)(value)); } while (0)
+#define STATS_ALLOC(bytes) \
+    do { if (statsEnabled) { statsAdd(STATS_ALLOC_COUNT, 1); statsAdd(STATS_ALLOC_BYTES, (uint64_t)(bytes)); } } while (0)
+
+uint64_t statsPhaseBegin(void);
+void statsPhaseEnd(StatsPhase phase, uint64_t start);
+void statsAdd(StatsCounter counter, uint64_t value);
+long statsPeakRssKb(void);
+void statsPrint(FILE *out, int json);
+int statsParseOption(const char *arg);
+
+#endif // STATS_H
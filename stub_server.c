@@ -0,0 +1,403 @@
+/* Local stand-in for the LLM endpoint used by send_request().
+ *
+ * Speaks just enough HTTP/1.1 to answer POST /v1/chat/completions with an
+ * OpenAI-style chat completion whose content is a "Vertices=n>>>..." matrix.
+ * The matrix is either a fixed canned string or generated from the prompt
+ * (vertex count and "X->Y" edges), following the same rules the system
+ * prompts in api_comm.c ask the model to follow. Batched requests (numbered
+ * "k) ..." lines) get one "k)Vertices=..." answer per line, separated by
+ * LLM_BATCH_SEPARATOR.
+ *
+ * Usage: stub_server [-p port] [-l latency_ms] [-j jitter_ms] [-f fail_rate]
+ *                    [-c canned_content] [-s seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define CLOSE_SOCKET closesocket
+#else
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <strings.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#endif
+
+#define STUB_MAX_HEADER 16384
+#define STUB_MAX_VERTICES 64
+#define STUB_MAX_USER 16384
+#define STUB_BATCH_SEPARATOR "###"  // LLM_BATCH_SEPARATOR in api_comm.h
+
+typedef struct StubConfig {
+    int port;
+    int latencyMs;
+    int jitterMs;
+    double failRate;
+    const char *canned;  // Fixed content, or NULL to generate from the prompt
+    unsigned long seed;
+} StubConfig;
+
+typedef struct StubConnection {
+    socket_t sock;
+    unsigned long id;
+} StubConnection;
+
+static StubConfig config = {1234, 0, 0, 0.0, NULL, 0};
+
+// xorshift64*, one state per connection so handlers never share an RNG
+static unsigned long long stub_rand(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+static double stub_uniform(unsigned long long *state) {
+    return (stub_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void stub_sleep_ms(int ms) {
+    if (ms <= 0) return;
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static int send_all(socket_t sock, const char *data, size_t len) {
+    while (len > 0) {
+        int sent = send(sock, data, (int)len, 0);
+        if (sent <= 0) return -1;
+        data += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+/* Finds the value of the last "content" field with the given role, i.e. the
+   text between the opening quote and the next unescaped quote. */
+static int extract_message(const char *body, const char *role, char *out, size_t outSize) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"role\": \"%s\", \"content\": \"", role);
+    const char *start = NULL;
+    for (const char *p = strstr(body, pattern); p; p = strstr(p + 1, pattern)) {
+        start = p + strlen(pattern);
+    }
+    if (!start) return -1;
+    size_t len = 0;
+    while (start[len] && !(start[len] == '"' && (len == 0 || start[len - 1] != '\\'))) len++;
+    if (len >= outSize) len = outSize - 1;
+    memcpy(out, start, len);
+    out[len] = '\0';
+    return 0;
+}
+
+/* Builds "Vertices=n>>>row|row|..." the way the model is instructed to:
+   mode 0 (extract) marks unspecified cells with F, mode 1 (generate) with 0,
+   mode 2 (random) fills everything randomly. Edges beyond n yield an X matrix. */
+static void generate_content(const char *system, const char *user, unsigned long long *rng,
+                             char *out, size_t outSize) {
+    int mode = 1;
+    if (strstr(system, "extract data")) mode = 0;
+    else if (strstr(system, "randomly generated")) mode = 2;
+
+    const char *p = user;
+    while (*p && !isdigit((unsigned char)*p)) p++;
+    int n = atoi(p);
+    if (n <= 0) n = 3;
+    if (n > STUB_MAX_VERTICES) n = STUB_MAX_VERTICES;
+
+    static const char fill[3] = {'F', '0', '0'};
+    char cells[STUB_MAX_VERTICES][STUB_MAX_VERTICES];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            cells[i][j] = mode == 2 ? (char)('0' + (stub_rand(rng) & 1)) : fill[mode];
+        }
+    }
+
+    int impossible = 0;
+    for (const char *arrow = strstr(user, "->"); arrow; arrow = strstr(arrow + 2, "->")) {
+        const char *src = arrow - 1;
+        const char *dst = arrow + 2;
+        while (src > user && *src == ' ') src--;
+        while (*dst == ' ') dst++;
+        if (src < user || !isupper((unsigned char)*src) || !isupper((unsigned char)*dst)) continue;
+        int s = *src - 'A';
+        int d = *dst - 'A';
+        if (s >= n || d >= n) {
+            impossible = 1;
+            continue;
+        }
+        cells[s][d] = '1';
+    }
+
+    int written = snprintf(out, outSize, "Vertices=%d>>>", n);
+    for (int i = 0; i < n && written < (int)outSize; i++) {
+        for (int j = 0; j < n && written < (int)outSize - 1; j++) {
+            out[written++] = impossible ? 'X' : cells[i][j];
+        }
+        if (i < n - 1 && written < (int)outSize - 1) out[written++] = '|';
+    }
+    if (written >= (int)outSize) written = (int)outSize - 1;
+    out[written] = '\0';
+}
+
+static int send_response(socket_t sock, int status, const char *reason, const char *body, int keepAlive) {
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: %s\r\n\r\n",
+        status, reason, strlen(body), keepAlive ? "keep-alive" : "close");
+    if (send_all(sock, header, len) != 0) return -1;
+    return send_all(sock, body, strlen(body));
+}
+
+static void handle_request(socket_t sock, unsigned long id, unsigned long requestNo,
+                           const char *requestLine, const char *body,
+                           unsigned long long *rng, int keepAlive) {
+    int delay = config.latencyMs;
+    if (config.jitterMs > 0) {
+        delay += (int)(stub_rand(rng) % (2 * config.jitterMs + 1)) - config.jitterMs;
+    }
+    stub_sleep_ms(delay);
+
+    if (strncmp(requestLine, "POST /v1/chat/completions", 25) != 0) {
+        send_response(sock, 404, "Not Found", "{\"error\": {\"message\": \"unknown endpoint\"}}", keepAlive);
+        return;
+    }
+    if (config.failRate > 0 && stub_uniform(rng) < config.failRate) {
+        send_response(sock, 503, "Service Unavailable",
+                      "{\"error\": {\"message\": \"injected failure\"}}", keepAlive);
+        return;
+    }
+
+    size_t answerSize = STUB_MAX_VERTICES * (STUB_MAX_VERTICES + 1) + 32;
+    char *system = malloc(4096);
+    char *user = malloc(STUB_MAX_USER);
+    char *content = malloc(answerSize);
+    if (!system || !user || !content) {
+        free(system);
+        free(user);
+        free(content);
+        send_response(sock, 500, "Internal Server Error", "{\"error\": {\"message\": \"out of memory\"}}", 0);
+        return;
+    }
+    if (extract_message(body, "system", system, 4096) != 0) system[0] = '\0';
+    if (extract_message(body, "user", user, STUB_MAX_USER) != 0) user[0] = '\0';
+
+    if (strstr(system, "numbered requests")) {
+        // One answer per "k) request" line; lines are separated by an escaped newline
+        size_t lines = 1;
+        for (const char *p = strstr(user, "\\n"); p; p = strstr(p + 2, "\\n")) lines++;
+        char *answers = malloc(lines * (answerSize + 16));
+        size_t used = 0;
+        int number = 1;
+        for (char *line = user; answers && line; number++) {
+            char *next = strstr(line, "\\n");
+            if (next) *next = '\0';
+            char *request = strchr(line, ')');
+            request = request ? request + 1 : line;
+            if (config.canned) snprintf(content, answerSize, "%s", config.canned);
+            else generate_content(system, request, rng, content, answerSize);
+            used += sprintf(answers + used, "%s%d)%s", number > 1 ? STUB_BATCH_SEPARATOR : "", number, content);
+            line = next ? next + 2 : NULL;
+        }
+        free(content);
+        content = answers;
+    } else if (config.canned) {
+        snprintf(content, answerSize, "%s", config.canned);
+    } else {
+        generate_content(system, user, rng, content, answerSize);
+    }
+    free(system);
+    free(user);
+    if (!content) {
+        send_response(sock, 500, "Internal Server Error", "{\"error\": {\"message\": \"out of memory\"}}", 0);
+        return;
+    }
+
+    size_t bodySize = strlen(content) + 512;
+    char *response = malloc(bodySize);
+    if (!response) {
+        free(content);
+        send_response(sock, 500, "Internal Server Error", "{\"error\": {\"message\": \"out of memory\"}}", 0);
+        return;
+    }
+    // Keep the ": " spacing, parseAdjacencyMatrix searches for "\"content\": \""
+    snprintf(response, bodySize,
+        "{\"id\": \"chatcmpl-stub-%lu-%lu\", \"object\": \"chat.completion\", \"created\": %ld, "
+        "\"model\": \"stub\", \"choices\": [{\"index\": 0, \"message\": {\"role\": \"assistant\", "
+        "\"content\": \"%s\"}, \"finish_reason\": \"stop\"}], "
+        "\"usage\": {\"prompt_tokens\": 0, \"completion_tokens\": 0, \"total_tokens\": 0}}",
+        id, requestNo, (long)time(NULL), content);
+    send_response(sock, 200, "OK", response, keepAlive);
+    free(response);
+    free(content);
+}
+
+static void *connection_thread(void *arg) {
+    StubConnection *conn = arg;
+    unsigned long long rng = (config.seed ^ (conn->id * 0x9E3779B97F4A7C15ULL)) | 1;
+    char *buffer = malloc(STUB_MAX_HEADER);
+    size_t used = 0;
+    unsigned long requestNo = 0;
+
+    while (buffer) {
+        // Read until the end of the headers
+        char *headerEnd = NULL;
+        while (!(headerEnd = strstr(buffer, "\r\n\r\n"))) {
+            if (used >= STUB_MAX_HEADER - 1) goto done;
+            int got = recv(conn->sock, buffer + used, (int)(STUB_MAX_HEADER - 1 - used), 0);
+            if (got <= 0) goto done;
+            used += got;
+            buffer[used] = '\0';
+        }
+        size_t headerLen = headerEnd + 4 - buffer;
+
+        size_t contentLength = 0;
+        int keepAlive = 1;
+        int expectContinue = 0;
+        for (char *h = buffer; h < headerEnd; h = strstr(h, "\r\n") + 2) {
+            if (strncasecmp(h, "Content-Length:", 15) == 0) contentLength = strtoul(h + 15, NULL, 10);
+            if (strncasecmp(h, "Connection: close", 17) == 0) keepAlive = 0;
+            if (strncasecmp(h, "Expect: 100-continue", 20) == 0) expectContinue = 1;
+        }
+        // libcurl asks for this on bodies over 1 KB, which every system prompt is
+        if (expectContinue && send_all(conn->sock, "HTTP/1.1 100 Continue\r\n\r\n", 25) != 0) goto done;
+
+        char *body = malloc(contentLength + 1);
+        if (!body) goto done;
+        size_t have = used - headerLen;
+        if (have > contentLength) have = contentLength;
+        memcpy(body, buffer + headerLen, have);
+        while (have < contentLength) {
+            int got = recv(conn->sock, body + have, (int)(contentLength - have), 0);
+            if (got <= 0) {
+                free(body);
+                goto done;
+            }
+            have += got;
+        }
+        body[contentLength] = '\0';
+
+        // Keep whatever pipelined bytes follow this request
+        size_t consumed = headerLen + contentLength;
+        size_t rest = used > consumed ? used - consumed : 0;
+        headerEnd[2] = '\0';
+        handle_request(conn->sock, conn->id, requestNo++, buffer, body, &rng, keepAlive);
+        memmove(buffer, buffer + consumed, rest);
+        used = rest;
+        buffer[used] = '\0';
+        free(body);
+        if (!keepAlive) break;
+    }
+done:
+    free(buffer);
+    CLOSE_SOCKET(conn->sock);
+    free(conn);
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [-p port] [-l latency_ms] [-j jitter_ms] [-f fail_rate] [-c canned_content] [-s seed]\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    config.seed = (unsigned long)time(NULL);
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-p") == 0) config.port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0) config.latencyMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0) config.jitterMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0) config.failRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0) config.canned = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0) config.seed = strtoul(argv[++i], NULL, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.port <= 0 || config.latencyMs < 0 || config.jitterMs < 0 ||
+        config.failRate < 0 || config.failRate > 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        fprintf(stderr, "WSAStartup failed\n");
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        fprintf(stderr, "Error creating socket\n");
+        return 1;
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)config.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 128) != 0) {
+        fprintf(stderr, "Error binding to 127.0.0.1:%d\n", config.port);
+        CLOSE_SOCKET(listener);
+        return 1;
+    }
+    printf("Stub LLM server listening on http://127.0.0.1:%d/v1/chat/completions\n", config.port);
+    fflush(stdout);
+
+    unsigned long nextId = 0;
+    while (1) {
+        socket_t client = accept(listener, NULL, NULL);
+        if (client == INVALID_SOCKET) continue;
+        // Header and body go out in separate sends; don't let Nagle hold the body back
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char *)&yes, sizeof(yes));
+        StubConnection *conn = malloc(sizeof(StubConnection));
+        if (!conn) {
+            CLOSE_SOCKET(client);
+            continue;
+        }
+        conn->sock = client;
+        conn->id = nextId++;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread, conn) != 0) {
+            fprintf(stderr, "Error creating connection thread\n");
+            CLOSE_SOCKET(client);
+            free(conn);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
@@ -20,4 +20,33 @@ int isEmptyLine(const char *str) {
         str++;
     }
     return 1;  // Only whitespace found
-}
\ No newline at end of file
+}
+// Writes value in decimal at out (at most 20 characters) and returns the end
+char *formatInt(char *out, long long value) {
+    char digits[20];
+    int count = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *out++ = '-';
+    while (count) *out++ = digits[--count];
+    return out;
+}
+
+// Little-endian 32-bit value for the binary formats, whatever the host order
+char *putInt32LE(char *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        *out++ = (char)(value >> (8 * i));
+    }
+    return out;
+}
+
+uint32_t getInt32LE(const char *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)(unsigned char)in[i] << (8 * i);
+    }
+    return value;
+}
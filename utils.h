@@ -2,8 +2,12 @@
 #define UTILS_H
 
 #include <ctype.h>
+#include <stdint.h>
 
 int parseVertexCount(const char *input);
 int isEmptyLine(const char *input);
+char *formatInt(char *out, long long value);
+char *putInt32LE(char *out, uint32_t value);
+uint32_t getInt32LE(const char *in);
 
 #endif
\ No newline at end of file